@@ -0,0 +1,110 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "../include/Cartridge.h"
+#include "../include/CPU.h"
+#include "../include/MainBus.h"
+#include "../include/Mapper.h"
+
+using namespace ANNESE;
+
+namespace {
+    constexpr const int CyclesPerFrame = 29781;
+
+    //A loop of loads, stores, arithmetic, shifts, read-modify-writes, page crossings, a taken branch and a
+    //subroutine call. It touches no I/O register, so it runs on the CPU alone
+    const std::vector<Byte> Program = {
+            0x78,             //8000 SEI
+            0xd8,             //8001 CLD
+            0xa2, 0xff,       //8002 LDX #$FF
+            0x9a,             //8004 TXS
+            0xa9, 0xf8,       //8005 LDA #$F8
+            0x85, 0x10,       //8007 STA $10
+            0xa9, 0x90,       //8009 LDA #$90
+            0x85, 0x11,       //800B STA $11       ($10),Y crosses a page from Y = 8 on
+            0xa2, 0x00,       //800D LDX #$00
+            0xa0, 0x00,       //800F LDY #$00
+            0xbd, 0xf0, 0x90, //8011 LDA $90F0,X   crosses a page from X = $10 on
+            0x65, 0x00,       //8014 ADC $00
+            0x9d, 0x00, 0x02, //8016 STA $0200,X
+            0xb1, 0x10,       //8019 LDA ($10),Y
+            0x49, 0x5a,       //801B EOR #$5A
+            0x25, 0x01,       //801D AND $01
+            0x19, 0x00, 0x03, //801F ORA $0300,Y
+            0x0a,             //8022 ASL A
+            0x66, 0x02,       //8023 ROR $02
+            0xe6, 0x03,       //8025 INC $03
+            0x88,             //8027 DEY
+            0xc9, 0x00,       //8028 CMP #$00      always sets the carry
+            0xb0, 0x00,       //802A BCS $802C
+            0x85, 0x00,       //802C STA $00
+            0x20, 0x39, 0x80, //802E JSR $8039
+            0xe8,             //8031 INX
+            0xd0, 0xdd,       //8032 BNE $8011
+            0xe6, 0x04,       //8034 INC $04       counts the iterations
+            0x4c, 0x11, 0x80, //8036 JMP $8011
+            0x48,             //8039 PHA
+            0x68,             //803A PLA
+            0x60,             //803B RTS
+    };
+
+    constexpr const Address IterationCounter = 0x0004;
+
+    //20 instructions 256 times, then INC and JMP
+    constexpr const long InstructionsPerIteration = 20 * 256 + 2;
+
+    //72 cycles 256 times, 240 page crossings in LDA abs,X and 248 in LDA (ind),Y, the last BNE not taken,
+    //then INC and JMP
+    constexpr const long CyclesPerIteration = 72 * 256 + 240 + 248 - 1 + 5 + 3;
+}
+
+/// Measures what an instruction costs the CPU alone, with a synthetic program in an NROM cartridge.
+/// Build with -DCMAKE_BUILD_TYPE=Release, the default build is not optimized.
+/// It only uses what the CPU and the buses have had from the start, so the same file builds against an older
+/// tree, from a worktree of it:
+/// g++ -std=c++17 -O2 -DMY_FILENAME='"x"' benchmark/CPUBenchmark.cpp src/CPU.cpp src/MainBus.cpp src/Mapper*.cpp
+///     src/Cartridge.cpp -o CPUBenchmark
+int main(int argc, char *argv[]) {
+    int frames = argc > 1 ? std::atoi(argv[1]) : 3000;
+    if (frames <= 0) {
+        std::cout << "Usage: \n> " << argv[0] << " [frames]" << std::endl;
+        return 2;
+    }
+
+    std::vector<Byte> prg(Program);
+    prg.resize(0x4000);
+    for (std::size_t i = 0x1000; i < 0x3000; ++i) {
+        prg[i] = static_cast<Byte>(i * 37);
+    }
+    //Reset vector
+    prg[0x3ffc] = 0x00;
+    prg[0x3ffd] = 0x80;
+    auto cartridge = std::make_unique<Cartridge>(std::move(prg), std::vector<Byte>(0x2000), 0, 0, false);
+    auto mainBus = std::make_shared<MainBus>();
+    mainBus->setMapper(Mapper::Create(std::move(cartridge), []() {}));
+    CPU cpu(mainBus);
+    cpu.reset();
+
+    //step runs an instruction or, in older trees, a cycle, so the iterations are counted from the RAM.
+    //A batch is shorter than an iteration either way, so the 8 bit counter can't wrap unseen
+    long iterations = static_cast<long>(frames) * CyclesPerFrame / CyclesPerIteration;
+    long done = 0;
+    Byte counter = mainBus->read(IterationCounter);
+    auto start = std::chrono::steady_clock::now();
+    while (done < iterations) {
+        for (int i = 0; i < 1024; ++i) {
+            cpu.step();
+        }
+        Byte now = mainBus->read(IterationCounter);
+        done += static_cast<Byte>(now - counter);
+        counter = now;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    long instructions = done * InstructionsPerIteration;
+    std::cout << frames << " frames, " << instructions << " instructions in "
+              << elapsed.count() << "s: " << elapsed.count() * 1e9 / instructions << " ns/instruction" << std::endl;
+    return 0;
+}
@@ -0,0 +1,12 @@
+#!/bin/sh
+#Time per frame of a bundled cartridge of each mapper type, without a display.
+#Usage: benchmark/MapperBenchmark.sh <build_directory> [frames]
+#The build directory must be configured with -DCMAKE_BUILD_TYPE=Release. Run it at two commits to compare them
+build="$1"
+frames="${2:-3000}"
+cartridges="$(dirname "$0")/../cartridges"
+for cartridge in "Battle City (Japan).nes" "Legend of Zelda, The (U) (PRG1) [!].nes" "Contra (USA).nes" \
+        "Arkanoid (USA).nes"; do
+    echo "$cartridge"
+    "$build/ANNESE_headless" "$cartridges/$cartridge" "$frames" 2>/dev/null
+done
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <functional>
+#include <utility>
+#include "Utility.h"
+
+namespace ANNESE {
+    /// What the PictureBus takes from the cartridge: the pattern tables and how the name tables are mirrored
+    class CHRMemory {
+    public:
+        enum class NameTableMirroring : Byte{
+            Horizontal = 0,
+            Vertical = 1,
+            FourScreen = 8,
+            OneScreenLower,
+            OneScreenHigher,
+        };
+
+        virtual ~CHRMemory() = default;
+
+        virtual void writeCHR(Address addr, Byte value) = 0;
+
+        /// Physical location of the CHR ROM or RAM byte mapped at the address
+        virtual const Byte *getCHRPtr(Address addr) const = 0;
+
+        virtual NameTableMirroring nameTableMirroring() const = 0;
+
+        /// Called every time the CHR banks are switched
+        void setCHRBankCallback(std::function<void(void)> cb) {
+            mCHRBankCallback = std::move(cb);
+        }
+
+    protected:
+        /// Must be called after switching the CHR banks
+        void switchedCHRBanks() {
+            if (mCHRBankCallback) {
+                mCHRBankCallback();
+            }
+        }
+
+        std::function<void(void)> mCHRBankCallback;
+    };
+}
@@ -2,11 +2,17 @@
 
 
 #include <memory>
-#include <bitset>
+#include <functional>
+#include <array>
+#include <utility>
+#include <vector>
+#include <unordered_map>
 #include "MainBus.h"
 #include "CPUOpcodes.h"
 
 namespace ANNESE {
+    class Profiler;
+
     class CPU {
     public:
         enum class Interruption {
@@ -15,6 +21,15 @@ namespace ANNESE {
             BRK
         };
 
+        enum class ExecutionMode {
+            /// Fetches and dispatches every instruction from the bus
+            Interpreter,
+            /// Runs code from the PRG ROM as basic blocks decoded once and cached
+            BlockCache,
+            /// Same as BlockCache, but every instruction is specialized for its operand as well
+            Compiled,
+        };
+
         explicit CPU(std::shared_ptr<MainBus> mainBus);
 
         virtual ~CPU() = default;
@@ -25,19 +40,164 @@ namespace ANNESE {
 
         void interrupt(Interruption inter);
 
-        void skipDMACycles() {
-            mSkipCycles += 513; // 256 read + 256 write + 1 dummy read
-            mSkipCycles += (mCycles & 1);   // +1 if on odd cycle
+        /// The NMI is served before the next instruction, so it is safe to request it in the middle of one
+        void requestNMI() {
+            mPendingNMI = true;
+        }
+
+        /// Stops executing after the current instruction, the cycles keep passing until it is resumed.
+        /// The bus is taken by the DMA meanwhile
+        void halt() {
+            mHalted = true;
+        }
+
+        void resume() {
+            mHalted = false;
         }
 
+        /// Executes one whole instruction
         void step();
 
+        /// Executes whole instructions until the cycle counter reaches the given cycle.
+        /// The last instruction may overshoot it. A halted CPU just lets the cycles pass
+        void runUntil(CycleCount cycle);
+
+        CycleCount cycles() const {
+            return mCycles;
+        }
+
+        void setExecutionMode(ExecutionMode mode);
+
+        /// The profiler sees every instruction, so the CPU only interprets while one is set
+        void setProfiler(std::shared_ptr<Profiler> profiler) {
+            mProfiler = std::move(profiler);
+        }
+
+        /// The callback returns the cycle before which reading PPUSTATUS keeps giving the same value.
+        /// Without it the loops polling PPUSTATUS are never skipped
+        void setPPUStatusHorizonCallback(std::function<CycleCount(void)> cb) {
+            mPPUStatusHorizonCallback = std::move(cb);
+        }
+
     protected:
-        void execute(Operation op, AddressingMode mode);
+        /// Bits of the status register
+        enum StatusFlag : Byte {
+            FlagC = 1 << 0,
+            FlagZ = 1 << 1,
+            FlagI = 1 << 2,
+            FlagD = 1 << 3,
+            FlagB = 1 << 4,
+            FlagUnused = 1 << 5,
+            FlagV = 1 << 6,
+            FlagN = 1 << 7,
+        };
+
+        /// The arithmetic flags are kept as the values they are computed from,
+        /// the status register is only assembled when it is pushed.
+        /// Declared after the bus pointers and the cycle counter so that all of them share a cache line
+        struct Registers {
+            Address PC;
+            Byte SP;
+            Byte A;
+            Byte X;
+            Byte Y;
+            /// Z is set when it is zero
+            Byte zero;
+            /// N is its bit 7
+            Byte negative;
+            /// V is its bit 7
+            Byte overflow;
+            /// C, either 0 or 1
+            Byte carry;
+            /// I, D, B and the unused bit in their places of the status register
+            Byte status;
+        };
+
+        /// Executes the instruction with its operand bytes already fetched and the PC past them
+        using Handler = void (CPU::*)(Address operand);
+
+        struct DecodedInstruction {
+            Handler handler;
+            Address operand;
+            Byte length;
+            Byte cycles;
+        };
+
+        /// Straight-line run of instructions that ends with a control flow instruction
+        struct BasicBlock {
+            std::vector<DecodedInstruction> instructions;
+
+            /// Only reads the RAM or PPUSTATUS and ends with a jump, so when it jumps back to its start
+            /// every iteration is the same as long as whatever it reads stays the same
+            bool idle = false;
+
+            bool pollsPPUStatus = false;
+        };
 
-        void executeBranch(Operation op);
+        /// The state at the end of the last iteration of an idle loop
+        struct IdleLoop {
+            Address PC = 0;
+            Byte A = 0;
+            Byte X = 0;
+            Byte Y = 0;
+            Byte SP = 0;
+            Byte status = 0;
+            CycleCount cycles = -1;
+        };
+
+        struct BlockSlot {
+            const BasicBlock *block = nullptr;
+            unsigned generation = 0;
+        };
+
+        /// Blocks never span an 8KB chunk of the PRG ROM, so that they do not span a bank either
+        static constexpr Address BlockChunkSize = 0x2000;
+
+        static constexpr std::size_t MaxBlockLength = 32;
+
+        static const std::array<Handler, 0x100> Handlers;
+
+        /// Same as Handlers, but the absolute addressing modes access the internal RAM directly
+        static const std::array<Handler, 0x100> RAMHandlers;
+
+        template<bool InRAM, std::size_t... Opcodes>
+        static constexpr std::array<Handler, 0x100> MakeHandlers(std::index_sequence<Opcodes...>);
+
+        void serveInterrupts();
+
+        void runBlock(CycleCount cycle);
+
+        /// Called after the idle block has looped back to its start. Once an iteration changes nothing,
+        /// skips whole iterations in bulk until something the loop reads might change
+        void skipIdleLoop(const BasicBlock &block, CycleCount iterationStart, CycleCount cycle);
+
+        const BasicBlock &findBlock(Address pc);
+
+        BasicBlock decodeBlock(const Byte *code, Address pc) const;
 
-        void execute1(Operation op, AddressingMode mode);
+        /// Executes the instruction, then the next ones until the cycle is reached or the CPU has to be seen to
+        /// for an NMI or a halt. A cycle already reached executes just the one
+        void execute(Byte opcode, CycleCount cycle);
+
+        template<Byte Length>
+        Address fetchOperand();
+
+        template<Operation Op, AddressingMode Mode, bool InRAM = false>
+        void execute(Address operand);
+
+        template<Operation Op, AddressingMode Mode>
+        Address effectiveAddress(Address operand);
+
+        /// Value of the operand, either immediate or read from the effective address
+        template<Operation Op, AddressingMode Mode, bool InRAM>
+        Byte load(Address operand);
+
+        /// The address must be known to be in the internal RAM for InRAM accesses
+        template<bool InRAM>
+        Byte readMemory(Address addr);
+
+        template<bool InRAM>
+        void writeMemory(Address addr, Byte value);
 
         Address readAddress(Address addr);
 
@@ -49,29 +209,37 @@ namespace ANNESE {
 
         void setZN(Byte value);
 
+        /// Assembles the status register from the flag sources
+        Byte status() const;
+
+        void setStatus(Byte value);
+
+        void profile(Address pc, Byte opcode, CycleLength cycles);
+
         std::shared_ptr<MainBus> mMainBus;
 
-        CycleLength mSkipCycles;
+        Byte *mRAM;
 
-        CycleLength mCycles;
+        CycleCount mCycles;
 
-        Address mRegPC;
+        bool mPendingNMI;
 
-        Byte mRegSP;
+        bool mHalted;
 
-        Byte mRegA;
+        Registers mRegs;
 
-        Byte mRegX;
+        ExecutionMode mExecutionMode = ExecutionMode::Compiled;
 
-        Byte mRegY;
+        /// Keyed by the physical location of the first instruction, so a block survives bank switching
+        std::unordered_map<const Byte *, BasicBlock> mBlocks;
 
-        std::bitset<8> mFlags;
-    };
+        /// Fast lookup by the PRG address, valid while the mapped banks stay the same
+        std::vector<BlockSlot> mBlockSlots;
 
-    class OpcodeDecoder {
-    public:
-        OpcodeDecoder() = delete;
+        IdleLoop mIdleLoop;
+
+        std::function<CycleCount(void)> mPPUStatusHorizonCallback;
 
-        static std::tuple<Operation, AddressingMode, CycleLength> Decode(const Byte opcode);
+        std::shared_ptr<Profiler> mProfiler;
     };
 }
\ No newline at end of file
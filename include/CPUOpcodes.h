@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include "MainBus.h"
 
 namespace ANNESE
@@ -226,4 +227,223 @@ namespace ANNESE
             2, 6, 0, 0, 3, 3, 5, 0, 2, 2, 2, 2, 4, 4, 6, 0,
             2, 5, 0, 0, 0, 4, 6, 0, 2, 4, 0, 0, 0, 4, 7, 0,
     };
-};
\ No newline at end of file
+
+    struct OpcodeInfo {
+        Operation operation;
+
+        AddressingMode mode;
+
+        /// 0 implies unused opcode
+        CycleLength cycles;
+
+        /// Opcode and operand bytes
+        Byte length;
+    };
+
+    /// Extra cycles taken when the indexed address crosses a page boundary
+    constexpr CycleLength PageCrossPenalty(Operation op, AddressingMode mode) {
+        switch (mode) {
+            case AddressingMode::IndirectY:
+            case AddressingMode::AbsoluteY:
+            case AddressingMode::AbsoluteX:
+                //Stores always take the extra cycle, so it is already counted in their base length
+                return op != Operation::STA ? 1 : 0;
+            case AddressingMode::AbsoluteIndexed:
+                return 1;
+            default:
+                return 0;
+        }
+    }
+
+    constexpr Byte InstructionLength(Operation op, AddressingMode mode) {
+        switch (mode) {
+            case AddressingMode::None:
+                return (op == Operation::JSR || op == Operation::JMP || op == Operation::JMPI) ? 3 : 1;
+            case AddressingMode::Accumulator:
+                return 1;
+            case AddressingMode::Absolute:
+            case AddressingMode::AbsoluteY:
+            case AddressingMode::AbsoluteX:
+            case AddressingMode::AbsoluteIndexed:
+                return 3;
+            default:
+                return 2;
+        }
+    }
+
+    constexpr bool IsAbsolute(AddressingMode mode) {
+        return mode == AddressingMode::Absolute || mode == AddressingMode::AbsoluteX ||
+               mode == AddressingMode::AbsoluteY || mode == AddressingMode::AbsoluteIndexed;
+    }
+
+    /// Whether the operation may continue anywhere but the next instruction
+    constexpr bool ChangesControlFlow(Operation op) {
+        switch (op) {
+            case Operation::BRK:
+            case Operation::JSR:
+            case Operation::RTI:
+            case Operation::RTS:
+            case Operation::JMP:
+            case Operation::JMPI:
+            case Operation::BCC:
+            case Operation::BCS:
+            case Operation::BEQ:
+            case Operation::BMI:
+            case Operation::BNE:
+            case Operation::BPL:
+            case Operation::BVC:
+            case Operation::BVS:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /// Repeating the operation with the same registers and memory gives the same result
+    constexpr bool IsIdempotentRead(Operation op) {
+        switch (op) {
+            case Operation::LDA:
+            case Operation::LDX:
+            case Operation::LDY:
+            case Operation::AND:
+            case Operation::ORA:
+            case Operation::BIT:
+            case Operation::CMP:
+            case Operation::CPX:
+            case Operation::CPY:
+            case Operation::NOP:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    constexpr OpcodeInfo DecodeOpcode_(const Byte opcode) {
+        CycleLength cycleLength = OperationCyclesAmount_[opcode];
+        using AMode = AddressingMode;
+        using Op = Operation;
+        using OpIm = OperationImplied_;
+        switch (static_cast<OpIm>(opcode)) {
+            case OpIm::NOP:  return {Op::NOP,  AMode::None, cycleLength};
+            case OpIm::BRK:  return {Op::BRK,  AMode::None, cycleLength};
+            case OpIm::JSR:  return {Op::JSR,  AMode::None, cycleLength};
+            case OpIm::RTI:  return {Op::RTI,  AMode::None, cycleLength};
+            case OpIm::RTS:  return {Op::RTS,  AMode::None, cycleLength};
+            case OpIm::JMP:  return {Op::JMP,  AMode::None, cycleLength};
+            case OpIm::JMPI: return {Op::JMPI, AMode::None, cycleLength};
+            case OpIm::PHP:  return {Op::PHP,  AMode::None, cycleLength};
+            case OpIm::PLP:  return {Op::PLP,  AMode::None, cycleLength};
+            case OpIm::PHA:  return {Op::PHA,  AMode::None, cycleLength};
+            case OpIm::PLA:  return {Op::PLA,  AMode::None, cycleLength};
+            case OpIm::DEY:  return {Op::DEY,  AMode::None, cycleLength};
+            case OpIm::DEX:  return {Op::DEX,  AMode::None, cycleLength};
+            case OpIm::TAY:  return {Op::TAY,  AMode::None, cycleLength};
+            case OpIm::INY:  return {Op::INY,  AMode::None, cycleLength};
+            case OpIm::INX:  return {Op::INX,  AMode::None, cycleLength};
+            case OpIm::CLC:  return {Op::CLC,  AMode::None, cycleLength};
+            case OpIm::SEC:  return {Op::SEC,  AMode::None, cycleLength};
+            case OpIm::CLI:  return {Op::CLI,  AMode::None, cycleLength};
+            case OpIm::SEI:  return {Op::SEI,  AMode::None, cycleLength};
+            case OpIm::TYA:  return {Op::TYA,  AMode::None, cycleLength};
+            case OpIm::CLV:  return {Op::CLV,  AMode::None, cycleLength};
+            case OpIm::CLD:  return {Op::CLD,  AMode::None, cycleLength};
+            case OpIm::SED:  return {Op::SED,  AMode::None, cycleLength};
+            case OpIm::TXA:  return {Op::TXA,  AMode::None, cycleLength};
+            case OpIm::TXS:  return {Op::TXS,  AMode::None, cycleLength};
+            case OpIm::TAX:  return {Op::TAX,  AMode::None, cycleLength};
+            case OpIm::TSX:  return {Op::TSX,  AMode::None, cycleLength};
+        }
+
+        if ((opcode & BranchInstructionMask) == BranchInstructionMaskResult) {
+            bool condition = (opcode & (1 << BranchConditionBit)) != 0;
+            switch (static_cast<BranchOnFlag_>(opcode >> BranchOnFlagShift)) {
+                case BranchOnFlag_::Negative:
+                    return {condition ? Op::BMI : Op::BPL, AMode::Relative, cycleLength};
+                case BranchOnFlag_::Overflow:
+                    return {condition ? Op::BVS : Op::BVC, AMode::Relative, cycleLength};
+                case BranchOnFlag_::Carry:
+                    return {condition ? Op::BCS : Op::BCC, AMode::Relative, cycleLength};
+                case BranchOnFlag_::Zero:
+                    return {condition ? Op::BEQ : Op::BNE, AMode::Relative, cycleLength};
+            }
+        }
+
+        if ((opcode & InstructionModeMask) == 0x1) {
+            AddressingMode addressingMode = AMode::None;
+            switch (static_cast<AddressingMode1_>((opcode & AddressingModeMask) >> AddressingModeShift)) {
+                case AddressingMode1_::IndexedIndirectX: addressingMode = AMode::IndexedIndirectX; break;
+                case AddressingMode1_::ZeroPage: addressingMode = AMode::ZeroPage; break;
+                case AddressingMode1_::Immediate: addressingMode = AMode::Immediate; break;
+                case AddressingMode1_::Absolute: addressingMode = AMode::Absolute; break;
+                case AddressingMode1_::IndirectY: addressingMode = AMode::IndirectY; break;
+                case AddressingMode1_::IndexedX: addressingMode = AMode::IndexedX; break;
+                case AddressingMode1_::AbsoluteY: addressingMode = AMode::AbsoluteY; break;
+                case AddressingMode1_::AbsoluteX: addressingMode = AMode::AbsoluteX; break;
+            }
+            switch (static_cast<Operation1_>((opcode & OperationMask) >> OperationShift)) {
+                case Operation1_::ORA: return {Op::ORA, addressingMode, cycleLength};
+                case Operation1_::AND: return {Op::AND, addressingMode, cycleLength};
+                case Operation1_::EOR: return {Op::EOR, addressingMode, cycleLength};
+                case Operation1_::ADC: return {Op::ADC, addressingMode, cycleLength};
+                case Operation1_::STA: return {Op::STA, addressingMode, cycleLength};
+                case Operation1_::LDA: return {Op::LDA, addressingMode, cycleLength};
+                case Operation1_::CMP: return {Op::CMP, addressingMode, cycleLength};
+                case Operation1_::SBC: return {Op::SBC, addressingMode, cycleLength};
+            }
+        }
+
+        if ((opcode & InstructionModeMask) == 0x2 || (opcode & InstructionModeMask) == 0x0) {
+            AddressingMode addressingMode = AMode::None;
+            switch (static_cast<AddressingMode2_>((opcode & AddressingModeMask) >> AddressingModeShift)) {
+                case AddressingMode2_::Immediate: addressingMode = AMode::Immediate; break;
+                case AddressingMode2_::ZeroPage: addressingMode = AMode::ZeroPage; break;
+                case AddressingMode2_::Accumulator: addressingMode = AMode::Accumulator; break;
+                case AddressingMode2_::Absolute: addressingMode = AMode::Absolute; break;
+                case AddressingMode2_::Indexed: addressingMode = AMode::Indexed; break;
+                case AddressingMode2_::AbsoluteIndexed: addressingMode = AMode::AbsoluteIndexed; break;
+            }
+            if (addressingMode == AMode::None) {
+                //Unused opcode, executed as a no-op
+                return {Op::NOP, AMode::None, cycleLength};
+            }
+            if ((opcode & InstructionModeMask) == 0x2) {
+                switch (static_cast<Operation2_>((opcode & OperationMask) >> OperationShift)) {
+                    case Operation2_::ASL: return {Op::ASL, addressingMode, cycleLength};
+                    case Operation2_::ROL: return {Op::ROL, addressingMode, cycleLength};
+                    case Operation2_::LSR: return {Op::LSR, addressingMode, cycleLength};
+                    case Operation2_::ROR: return {Op::ROR, addressingMode, cycleLength};
+                    case Operation2_::STX: return {Op::STX, addressingMode, cycleLength};
+                    case Operation2_::LDX: return {Op::LDX, addressingMode, cycleLength};
+                    case Operation2_::DEC: return {Op::DEC, addressingMode, cycleLength};
+                    case Operation2_::INC: return {Op::INC, addressingMode, cycleLength};
+                }
+            } else {
+                switch (static_cast<Operation0_>((opcode & OperationMask) >> OperationShift)) {
+                    case Operation0_::BIT: return {Op::BIT, addressingMode, cycleLength};
+                    case Operation0_::STY: return {Op::STY, addressingMode, cycleLength};
+                    case Operation0_::LDY: return {Op::LDY, addressingMode, cycleLength};
+                    case Operation0_::CPY: return {Op::CPY, addressingMode, cycleLength};
+                    case Operation0_::CPX: return {Op::CPX, addressingMode, cycleLength};
+                }
+            }
+        }
+        //Unused opcode, executed as a no-op
+        return {Op::NOP, AMode::None, cycleLength};
+    }
+
+    constexpr OpcodeInfo DecodeOpcode(const Byte opcode) {
+        OpcodeInfo info = DecodeOpcode_(opcode);
+        info.length = InstructionLength(info.operation, info.mode);
+        return info;
+    }
+
+    constexpr std::array<OpcodeInfo, 0x100> MakeOpcodeTable() {
+        std::array<OpcodeInfo, 0x100> table{};
+        for (int opcode = 0; opcode < 0x100; ++opcode) {
+            table[opcode] = DecodeOpcode(static_cast<Byte>(opcode));
+        }
+        return table;
+    }
+
+    constexpr const std::array<OpcodeInfo, 0x100> OpcodeTable = MakeOpcodeTable();
+}
@@ -10,6 +10,12 @@ namespace ANNESE {
 
         struct Application {
             float scale;
+
+            /// Render the picture on a thread of its own
+            bool renderThread;
+
+            /// The frames emulated in the time of one while fast-forwarding, 0 for as many as possible
+            unsigned fastForward;
         };
 
         struct Joypad {
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <iosfwd>
+#include <memory>
+#include "Utility.h"
+#include "VideoSink.h"
+#include "InputSource.h"
+#include "EventQueue.h"
+
+namespace ANNESE {
+    class Mapper;
+
+    class MainBus;
+
+    class PictureBus;
+
+    class PPU;
+
+    class CPU;
+
+    class Joypad;
+
+    class Profiler;
+
+    /// The components of the NES wired together. It knows nothing about windows or keyboards,
+    /// the pictures go to the video sink and the joypads read the input sources
+    class Console {
+    public:
+        Console(std::shared_ptr<VideoSink> video,
+                std::shared_ptr<InputSource> player1, std::shared_ptr<InputSource> player2);
+
+        virtual ~Console() = default;
+
+        /// Inserts the cartridge and resets, false if it can't be loaded
+        bool load(std::istream &rom);
+
+        /// Renders the picture on a thread of its own from the next cartridge loaded on
+        void setRenderThread(bool renderThread) {
+            mRenderThread = renderThread;
+        }
+
+        void setProfiler(std::shared_ptr<Profiler> profiler);
+
+        /// Runs the CPU by whole instructions until the given cycle, the PPU catches up only when it has to
+        /// and the events are handled as they come due
+        void emulateUntil(CycleCount cycle);
+
+        /// Runs until the next vertical blank starts, so every call emulates exactly one frame of the PPU,
+        /// the dot skipped on odd frames included
+        void runFrame();
+
+        CycleCount cycles() const;
+
+        /// The mapper of the cartridge loaded, null before
+        std::shared_ptr<const Mapper> mapper() const {
+            return mMapper;
+        }
+
+    protected:
+        static constexpr const int DotsPerCycle = 3;
+
+        /// The first CPU cycle at or after the dot
+        static CycleCount ToCycle(CycleCount dot) {
+            return (dot + DotsPerCycle - 1) / DotsPerCycle;
+        }
+
+        /// Advances the PPU to the current CPU cycle and flushes its picture, so that an access may follow
+        void syncPPU();
+
+        /// Handles the events due by the master clock
+        void dispatchEvents();
+
+        void doOAMDMA(Byte page);
+
+        /// Writes to Joy1 strobe both controllers
+        void strobeJoypads(Byte value);
+
+        std::shared_ptr<Mapper> mMapper;
+
+        std::shared_ptr<MainBus> mMainBus;
+
+        std::shared_ptr<PictureBus> mPictureBus;
+
+        std::shared_ptr<CPU> mCPU;
+
+        std::shared_ptr<PPU> mPPU;
+
+        std::shared_ptr<Joypad> mJoypad1;
+
+        std::shared_ptr<Joypad> mJoypad2;
+
+        /// The master clock in PPU dots, the PPU has been advanced up to it
+        CycleCount mClock = 0;
+
+        /// Timed on the master clock
+        EventQueue mEvents;
+
+        /// The CPU cycles taken by the DMA started during the last instruction, without the alignment cycle,
+        /// 0 if none
+        CycleLength mDMALength = 0;
+
+        bool mRenderThread = false;
+    };
+}
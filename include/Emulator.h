@@ -1,29 +1,24 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <chrono>
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <SFML/Graphics/Text.hpp>
+#include <SFML/Window/Keyboard.hpp>
+#include "Utility.h"
 
 namespace ANNESE {
 
-    class Cartridge;
-
-    class Mapper;
-
-    class MainBus;
-
-    class PictureBus;
+    class Console;
 
     class Screen;
 
-    class PPU;
-
-    class CPU;
+    class KeyboardInput;
 
     class Configuration;
 
-    class Joypad;
+    class Profiler;
 
     class Emulator {
     public:
@@ -33,26 +28,25 @@ namespace ANNESE {
 
         void run(std::istream &rom);
 
+        void setProfiler(std::shared_ptr<Profiler> profiler);
+
     protected:
         bool initLogoText(sf::Text &acronym, sf::Text &fullName, sf::Font &font) const;
 
-        std::shared_ptr<Mapper> mMapper;
-
-        std::shared_ptr<MainBus> mMainBus;
-
-        std::shared_ptr<PictureBus> mPictureBus;
+        /// Emulates frame by frame, paced by the wall clock, until told to stop. The pictures and the keys
+        /// go through the Screen and the KeyboardInputs, so it runs on a thread of its own
+        void emulate(const std::atomic<bool> &emulating);
 
         std::shared_ptr<Screen> mScreen;
 
-        std::shared_ptr<CPU> mCPU;
-
-        std::shared_ptr<PPU> mPPU;
+        std::shared_ptr<KeyboardInput> mKeyboard1;
 
-        std::shared_ptr<Joypad> mJoypad1;
+        std::shared_ptr<KeyboardInput> mKeyboard2;
 
-        std::shared_ptr<Joypad> mJoypad2;
+        std::shared_ptr<Console> mConsole;
 
-        static constexpr const auto CPUCycleDuration = std::chrono::nanoseconds(559); // NOLINT nanoseconds doesn't throw
+        /// Held down, it runs the emulation faster
+        static constexpr const sf::Keyboard::Key FastForwardKey = sf::Keyboard::Tab;
 
         static constexpr const auto LogoDuration = std::chrono::seconds(4); // NOLINT
 
@@ -61,5 +55,11 @@ namespace ANNESE {
         static constexpr const float LogoLinesSpacing = 20.f;
 
         sf::RenderWindow mWindow;
+
+        /// 0 runs unthrottled
+        unsigned mFastForwardFactor;
+
+        /// Set by the window thread while the fast-forward key is held
+        std::atomic<bool> mFastForward{false};
     };
 }
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include "Utility.h"
+
+namespace ANNESE {
+    /// The things that happen at a known time on the master clock, so that the CPU can be run right up to
+    /// the next one instead of checking for them after every instruction.
+    /// Every kind is pending at most once, and there are so few of them that finding the next one is a scan
+    class EventQueue {
+    public:
+        enum class Event : Byte {
+            /// The vertical blank starts and raises the NMI if it is enabled. The time is a lower bound,
+            /// the event is scheduled again if it comes early
+            VBlank,
+            /// The sprite DMA is done and gives the bus back to the CPU
+            DMA,
+            Count,
+        };
+
+        static constexpr const CycleCount Never = std::numeric_limits<CycleCount>::max();
+
+        EventQueue() {
+            clear();
+        }
+
+        /// Replaces the pending event of the same kind
+        void schedule(Event event, CycleCount time) {
+            mTimes[static_cast<std::size_t>(event)] = time;
+            update();
+        }
+
+        void cancel(Event event) {
+            schedule(event, Never);
+        }
+
+        void clear() {
+            mTimes.fill(Never);
+            mNext = Never;
+        }
+
+        /// The time of the earliest pending event, Never if there is none
+        CycleCount next() const {
+            return mNext;
+        }
+
+        /// Takes the earliest event due at the given time, false if there is none
+        bool pop(CycleCount time, Event &event) {
+            if (mNext > time) {
+                return false;
+            }
+            for (std::size_t i = 0; i < mTimes.size(); ++i) {
+                if (mTimes[i] == mNext) {
+                    event = static_cast<Event>(i);
+                    cancel(event);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    protected:
+        void update() {
+            mNext = Never;
+            for (CycleCount time : mTimes) {
+                mNext = std::min(mNext, time);
+            }
+        }
+
+        std::array<CycleCount, static_cast<std::size_t>(Event::Count)> mTimes;
+
+        CycleCount mNext;
+    };
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace ANNESE {
+    /// A picture as the PPU produces it, row by row. Every pixel holds the 6 bit color index
+    /// in its low bits and the color emphasis bits of PPUMASK above them
+    class FrameBuffer {
+    public:
+        using Pixel = std::uint16_t;
+
+        static constexpr const int Width = 256;
+
+        static constexpr const int Height = 240;
+
+        static constexpr const Pixel ColorMask = 0x3f;
+
+        static constexpr const int EmphasisShift = 6;
+
+        /// Every combination of a color index and the emphasis bits
+        static constexpr const int ColorCount = 8 << EmphasisShift;
+
+        Pixel *row(int y) {
+            return &mPixels[y * Width];
+        }
+
+        const Pixel *row(int y) const {
+            return &mPixels[y * Width];
+        }
+
+        const Pixel *data() const {
+            return mPixels.data();
+        }
+
+    protected:
+        alignas(32) std::array<Pixel, Width * Height> mPixels{};
+    };
+}
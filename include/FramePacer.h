@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ratio>
+
+namespace ANNESE {
+    /// Spaces the emulated frames out in wall-clock time. The deadlines are counted from the start of the run,
+    /// so that they don't drift, and they are met by sleeping most of the way and spinning the rest
+    class FramePacer {
+    public:
+        enum class Mode {
+            RealTime,
+            /// Several frames in the time of one
+            FastForward,
+            Unthrottled,
+        };
+
+        using Clock = std::chrono::steady_clock;
+
+        /// The NTSC master clock, 236.25 / 11 MHz
+        using MasterClock = std::chrono::duration<std::int64_t, std::ratio<11, 236250000>>;
+
+        /// 89341.5 PPU dots of 4 master clock cycles, on average over an odd and an even frame
+        static constexpr const MasterClock FrameDuration{357366};
+
+        FramePacer();
+
+        void setMode(Mode mode);
+
+        Mode mode() const {
+            return mMode;
+        }
+
+        /// The frames emulated in the time of one in the fast-forward mode
+        void setFastForwardFactor(unsigned factor);
+
+        /// Waits until the frame just emulated is due
+        void wait();
+
+    protected:
+        /// Starts counting the deadlines over from now
+        void restart();
+
+        /// Sleeping may take this much longer than asked for, the rest is spun away
+        static constexpr const auto SpinDuration = std::chrono::milliseconds(2); // NOLINT
+
+        /// Falling further behind than this starts the deadlines over instead of catching up
+        static constexpr const auto MaxLag = std::chrono::milliseconds(100); // NOLINT
+
+        Mode mMode = Mode::RealTime;
+
+        unsigned mFastForwardFactor = 4;
+
+        Clock::time_point mStart;
+
+        std::uint64_t mFrames = 0;
+    };
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "VideoSink.h"
+#include "InputSource.h"
+
+namespace ANNESE {
+    /// Keeps the last picture in memory, for the runs without a display
+    class HeadlessVideo : public VideoSink {
+    public:
+        void setPicture(const FrameBuffer &picture) override {
+            mPicture = picture;
+            ++mPictureCount;
+        }
+
+        const FrameBuffer &picture() const {
+            return mPicture;
+        }
+
+        std::uint64_t pictureCount() const {
+            return mPictureCount;
+        }
+
+    protected:
+        FrameBuffer mPicture;
+
+        std::uint64_t mPictureCount = 0;
+    };
+
+    /// Buttons pressed by the program rather than by a player, from any thread
+    class HeadlessInput : public InputSource {
+    public:
+        void setButtons(Byte buttons) {
+            mButtons.store(buttons, std::memory_order_relaxed);
+        }
+
+        Byte buttons() override {
+            return mButtons.load(std::memory_order_relaxed);
+        }
+
+    protected:
+        std::atomic<Byte> mButtons{0};
+    };
+}
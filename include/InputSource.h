@@ -0,0 +1,15 @@
+#pragma once
+
+#include "Utility.h"
+
+namespace ANNESE {
+    /// Where a joypad takes its buttons from when the game strobes it, on the thread that runs the emulation
+    class InputSource {
+    public:
+        virtual ~InputSource() = default;
+
+        /// One bit per button in the order the joypad reports them, from the lowest:
+        /// A, B, Select, Start, Up, Down, Left, Right
+        virtual Byte buttons() = 0;
+    };
+}
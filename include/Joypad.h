@@ -1,14 +1,13 @@
 #pragma once
 
-#include <SFML/Window/Keyboard.hpp>
-#include <vector>
+#include <memory>
 #include "Utility.h"
-#include "ConfigManager.h"
+#include "InputSource.h"
 
 namespace ANNESE {
     class Joypad {
     public:
-        explicit Joypad(const Configuration::Joypad &conf);
+        explicit Joypad(std::shared_ptr<InputSource> input);
 
         virtual ~Joypad() = default;
 
@@ -28,10 +27,10 @@ namespace ANNESE {
             Right,
         };
 
+        std::shared_ptr<InputSource> mInput;
+
         bool mStrobe;
 
         Byte mKeyStates;
-
-        std::vector<sf::Keyboard::Key> mKeyBindings;
     };
-}
\ No newline at end of file
+}
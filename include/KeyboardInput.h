@@ -0,0 +1,27 @@
+#pragma once
+
+#include <SFML/Window/Keyboard.hpp>
+#include <atomic>
+#include <vector>
+#include "InputSource.h"
+#include "ConfigManager.h"
+
+namespace ANNESE {
+    /// The keys bound to the buttons of a joypad, sampled by the thread owning the window
+    class KeyboardInput : public InputSource {
+    public:
+        explicit KeyboardInput(const Configuration::Joypad &conf);
+
+        /// Samples the keyboard. The emulation sees the buttons as last sampled
+        void poll();
+
+        Byte buttons() override {
+            return mButtons.load(std::memory_order_relaxed);
+        }
+
+    protected:
+        std::vector<sf::Keyboard::Key> mKeyBindings;
+
+        std::atomic<Byte> mButtons{0};
+    };
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <array>
 #include <functional>
 #include "Utility.h"
 #include "Mapper.h"
@@ -26,34 +27,116 @@ namespace ANNESE {
 
         virtual ~MainBus() = default;
 
-        Byte read(Address addr);
+        Byte read(Address addr) {
+            if (const Byte *page = mReadPages[addr >> 8]) {
+                return page[addr & 0xff];
+            }
+            return readIO(addr);
+        }
 
-        void write(Address addr, Byte value);
+        void write(Address addr, Byte value) {
+            if (Byte *page = mWritePages[addr >> 8]) {
+                page[addr & 0xff] = value;
+                return;
+            }
+            writeIO(addr, value);
+        }
 
         bool setMapper(std::shared_ptr<Mapper> mapper);
 
-        MainBus &setWriteCallback(IORegisters reg, std::function<void(Byte)> cb) {
-            mWriteCallbacks[reg] = std::move(cb);
+        /// Binds a register to a member function, e.g. setWriteCallback<PPU, &PPU::control>(IORegisters::PPUCtrl, ppu)
+        template<typename T, void (T::*Method)(Byte)>
+        MainBus &setWriteCallback(IORegisters reg, T *object) {
+            mWriteHandlers[RegisterIndex(reg)] = {object, [](void *object, Byte value) {
+                (static_cast<T *>(object)->*Method)(value);
+            }};
+            return *this;
+        }
+
+        template<typename T, Byte (T::*Method)()>
+        MainBus &setReadCallback(IORegisters reg, T *object) {
+            mReadHandlers[RegisterIndex(reg)] = {object, [](void *object) {
+                return (static_cast<T *>(object)->*Method)();
+            }};
             return *this;
         }
 
-        MainBus &setReadCallback(IORegisters reg, std::function<Byte(void)> cb) {
-            mReadCallbacks[reg] = std::move(cb);
+        /// Called before every access that can affect the picture: PPU registers, OAM DMA and mapper writes
+        MainBus &setPPUSyncCallback(std::function<void(void)> cb) {
+            mPPUSyncCallback = std::move(cb);
             return *this;
         }
 
+        /// Any page of plain memory, e.g. for OAM DMA
         const Byte *getPagePtr(Byte page);
 
+        /// The internal 2KB RAM, for accesses known to never reach anything else
+        Byte *RAM() {
+            return mRAM.data();
+        }
+
+        /// Physical location of the PRG ROM byte mapped at the given address
+        const Byte *getPRGPtr(Address addr) const {
+            return mMapper->getPagePtr(addr);
+        }
+
+        /// -1 outside of the PRG ROM
+        int prgBank(Address addr) const {
+            return addr >= static_cast<Address>(MemoryMap::PRG) ? mMapper->prgBank(addr) : -1;
+        }
+
+        unsigned prgBankGeneration() const {
+            return mMapper->prgBankGeneration();
+        }
+
     protected:
+        /// Everything that is not a page of plain memory: I/O registers, mapper registers and unmapped areas
+        Byte readIO(Address addr);
+
+        void writeIO(Address addr, Byte value);
+
+        void updatePRGPages();
+
         std::vector<Byte> mRAM;
 
         std::vector<Byte> mExtRAM;
 
         std::shared_ptr<Mapper> mMapper;
 
-        std::unordered_map<IORegisters, std::function<void(Byte)>> mWriteCallbacks;
+        /// A member function bound to its object, cheaper to call than std::function
+        struct WriteHandler {
+            void *object = nullptr;
+
+            void (*call)(void *object, Byte value) = nullptr;
+        };
+
+        struct ReadHandler {
+            void *object = nullptr;
+
+            Byte (*call)(void *object) = nullptr;
+        };
+
+        /// The 8 PPU registers followed by the APU and I/O registers from 0x4000 to 0x4017
+        static constexpr const std::size_t RegisterCount = 0x20;
+
+        static constexpr std::size_t RegisterIndex(Address addr) {
+            return addr < 0x4000 ? addr & 0x7u : 0x8u + (addr - 0x4000);
+        }
+
+        static constexpr std::size_t RegisterIndex(IORegisters reg) {
+            return RegisterIndex(static_cast<Address>(reg));
+        }
+
+        std::array<WriteHandler, RegisterCount> mWriteHandlers{};
+
+        std::array<ReadHandler, RegisterCount> mReadHandlers{};
+
+        std::function<void(void)> mPPUSyncCallback;
+
+        /// Page pointers indexed by the high byte of the address, null where the access needs a handler
+        std::array<const Byte *, 0x100> mReadPages;
 
-        std::unordered_map<IORegisters, std::function<Byte(void)>> mReadCallbacks;
+        std::array<Byte *, 0x100> mWritePages;
 
         enum class MemoryMap : Address{
             RAM = 0x0,
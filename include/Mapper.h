@@ -5,18 +5,11 @@
 #include <functional>
 #include "Utility.h"
 #include "Cartridge.h"
+#include "CHRMemory.h"
 
 namespace ANNESE {
-    class Mapper {
+    class Mapper : public CHRMemory {
     public:
-        enum class NameTableMirroring : Byte{
-            Horizontal = 0,
-            Vertical = 1,
-            FourScreen = 8,
-            OneScreenLower,
-            OneScreenHigher,
-        };
-
         enum class Type {
             NROM = 0,
             SxROM = 1,
@@ -34,24 +27,58 @@ namespace ANNESE {
 
         virtual Byte readPRG(Address addr) const = 0;
 
-        virtual void writeCHR(Address addr, Byte value) = 0;
-
         virtual Byte readCHR(Address addr) const = 0;
 
         /// DMA
         virtual const Byte *getPagePtr(Address addr) const = 0;
 
-        virtual NameTableMirroring nameTableMirroring() const {
+        NameTableMirroring nameTableMirroring() const override {
             return static_cast<NameTableMirroring>(mCartridge->nameTableMirroring());
         }
 
+        Type type() const {
+            return static_cast<Type>(mCartridge->mapperNumber());
+        }
+
+        /// The supported mappers never bank the CHR RAM, it is always mapped as a whole
+        bool hasCHRRAM() const {
+            return mCartridge->VROM().empty();
+        }
+
         virtual bool hasExtendedRAM() const {
             return mCartridge->hasExtendedRAM();
         }
 
+        /// Index of the 16KB PRG ROM bank mapped at the address
+        int prgBank(Address addr) const {
+            return static_cast<int>((getPagePtr(addr) - mCartridge->ROM().data()) / 0x4000);
+        }
+
+        /// Changes every time the PRG banks are switched, so that code decoded from them can be revalidated
+        unsigned prgBankGeneration() const {
+            return mPRGBankGeneration;
+        }
+
+        /// Called every time the PRG banks are switched
+        void setPRGBankCallback(std::function<void(void)> cb) {
+            mPRGBankCallback = std::move(cb);
+        }
+
         static std::shared_ptr<Mapper> Create(std::unique_ptr<Cartridge> &&cartridge,
                                               std::function<void(void)> mirroringCallback);
     protected:
+        /// Every mapper must call it after switching the PRG banks
+        void switchedPRGBanks() {
+            ++mPRGBankGeneration;
+            if (mPRGBankCallback) {
+                mPRGBankCallback();
+            }
+        }
+
         std::unique_ptr<Cartridge> mCartridge;
+
+        unsigned mPRGBankGeneration = 0;
+
+        std::function<void(void)> mPRGBankCallback;
     };
 }
\ No newline at end of file
@@ -19,6 +19,8 @@ namespace ANNESE {
 
         const Byte *getPagePtr(Address addr) const override;
 
+        const Byte *getCHRPtr(Address addr) const override;
+
     protected:
         bool mOneBank;
 
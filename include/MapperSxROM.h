@@ -20,6 +20,8 @@ namespace ANNESE {
 
         const Byte *getPagePtr(Address addr) const override;
 
+        const Byte *getCHRPtr(Address addr) const override;
+
         NameTableMirroring nameTableMirroring() const override;
 
     protected:
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <memory>
-#include <functional>
 #include "PictureBus.h"
-#include "Screen.h"
+#include "VideoSink.h"
+#include "FrameBuffer.h"
+#include "ScanlineCompositor.h"
+#include "ScanlineRenderer.h"
+#include "PPURenderer.h"
 
 namespace ANNESE {
     class PPU {
@@ -12,16 +15,50 @@ namespace ANNESE {
 
         static constexpr const unsigned ScanlineVisibleDots = 256;
 
-        PPU(std::shared_ptr<PictureBus> pictureBus, std::shared_ptr<Screen> screen);
+        PPU(std::shared_ptr<PictureBus> pictureBus, std::shared_ptr<VideoSink> video);
 
-        virtual ~PPU() = default;
+        virtual ~PPU();
 
         void step();
 
         void reset();
 
-        void setInterruptCallback(std::function<void(void)> cb) {
-            mVBlankCallback = cb;
+        /// Produces the pixels of the dots stepped so far on the current scanline.
+        /// Must be called before anything that affects the picture changes: PPU registers, OAM or CHR banks
+        void flush();
+
+        /// Lower bound of the dots left until the vertical blank starts, counting the dot that starts it
+        int dotsUntilVBlank() const;
+
+        /// Lower bound of the dots left until the value of PPUSTATUS can change by itself,
+        /// counting the dot that changes it
+        int dotsUntilStatusChange() const;
+
+        /// Vertical blanks started since the power on
+        std::uint64_t frameCount() const {
+            return mFrameCount;
+        }
+
+        /// The last complete frame, it stays unchanged while the next one is rendered
+        const FrameBuffer &frame() const {
+            return mFrames[mFrontFrame];
+        }
+
+        /// Frames started while it is on keep all the timing, the registers and the sprite 0 hit,
+        /// but produce no picture
+        void setFrameSkip(bool skip) {
+            mSkipFrames = skip;
+        }
+
+        /// Hands the scanlines produced in one pass over to the renderer, the others are still produced here.
+        /// It must be set before anything is written to the PPU memory
+        void setRenderer(std::shared_ptr<PPURenderer> renderer);
+
+        /// The NMI output, latched at the start of the vertical blank if it is enabled. Taking it clears it
+        bool takeNMI() {
+            bool nmi = mNMI;
+            mNMI = false;
+            return nmi;
         }
 
         void doDMA(const Byte *page);
@@ -58,20 +95,78 @@ namespace ANNESE {
             return mPictureBus->read(addr);
         }
 
+        std::uint64_t readPatternRow(Address addr) {
+            return mPictureBus->readPatternRow(addr);
+        }
+
+        /// The frame buffer pixel of a palette address, as PPUMASK shows it
+        FrameBuffer::Pixel pixel(Byte paletteAddr) const {
+            return (mPictureBus->readPalette(paletteAddr) & mGrayscaleMask) | mEmphasis;
+        }
+
+        /// A scanline not interrupted by a flush is produced in one pass, otherwise dot by dot
+        void renderPixels(int end);
+
+        void renderScanline();
+
+        /// The registers and the sprites of the current scanline
+        ScanlineState scanlineState() const;
+
+        /// Tells the renderer about the CHR banks and the name tables switched since it last heard of them
+        void updateRendererLayout();
+
+        /// Does only what a rendered scanline does to the registers and the sprite 0 hit
+        void skipScanline();
+
+        /// Whether an opaque pixel of the sprite 0 falls on an opaque background pixel of the current scanline,
+        /// as ScanlineRenderer::Render would find it. The VRAM address must be the one the line starts with
+        bool spriteZeroHitsBackground();
+
+        void renderDot(int x);
+
+        /// Loads the tile at the current VRAM address into the low bytes of the shift registers
+        void fetchBackgroundTile();
+
+        void incrementCoarseX();
+
+        /// Fills the sprite line buffer for the current scanline from the sprites found on the previous one
+        void rasterizeSprites();
+
+        /// One bit per OAM entry whose Y coordinate puts it on the scanline
+        std::uint64_t spritesInRange(int scanline) const;
+
+        /// The same one sprite at a time, what spritesInRange does without SSE2
+        std::uint64_t spritesInRangeScalar(int scanline) const;
+
+        /// The first visible scanline, not before the given one, on which the sprite 0 may still hit the background,
+        /// -1 if there is none
+        int spriteZeroHitScanline(int from) const;
+
         static constexpr const int ScanlineEndCycle = 340;
 
         static constexpr const int FrameEndScanline = 261;
 
         std::shared_ptr<PictureBus> mPictureBus;
 
-        std::shared_ptr<Screen> mScreen;
+        std::shared_ptr<VideoSink> mVideo;
+
+        std::shared_ptr<PPURenderer> mRenderer;
 
-        std::function<void(void)> mVBlankCallback;
+        /// The PictureBus layout the renderer knows about
+        unsigned mRendererLayout = 0;
+
+        ScanlineCompositor::Kernel mCompositeScanline;
 
         std::vector<Byte> mSpriteMemory;
 
         std::vector<Byte> mScanlineSprites;
 
+        /// Palette addresses of the front-most opaque sprite pixels,
+        /// with the ScanlineCompositor priority and sprite 0 flags, 0 where none
+        std::array<Byte, ScanlineVisibleDots> mSpriteLine{};
+
+        bool mSpriteLineValid = false;
+
         enum class State {
             PreRender,
             Render,
@@ -85,8 +180,13 @@ namespace ANNESE {
 
         int mScanline;
 
+        /// Pixels of the current scanline already produced
+        int mRenderedDots = 0;
+
         bool mEvenFrame;
 
+        std::uint64_t mFrameCount = 0;
+
         bool mVBlank;
 
         bool mSprZeroHit;
@@ -97,6 +197,15 @@ namespace ANNESE {
 
         Byte mFineXScroll;
 
+        /// Background shift registers of the per-dot renderer, the leftmost pixel is in the top bit
+        std::uint16_t mBgPatternLow = 0;
+
+        std::uint16_t mBgPatternHigh = 0;
+
+        std::uint16_t mBgAttributeLow = 0;
+
+        std::uint16_t mBgAttributeHigh = 0;
+
         bool mFirstWrite;
 
         Byte mDataBuffer;
@@ -107,6 +216,8 @@ namespace ANNESE {
 
         bool mGenerateInterrupt;
 
+        bool mNMI = false;
+
         bool mShowSprites;
 
         bool mShowBackground;
@@ -126,6 +237,22 @@ namespace ANNESE {
 
         Address mDataAddrIncrement;
 
-        std::vector<std::vector<sf::Color>> mPictureBuffer;
+        /// PPUMASK color emphasis bits, as they are stored in the pixels
+        FrameBuffer::Pixel mEmphasis = 0;
+
+        /// Grayscale keeps only the brightness of the color index
+        Byte mGrayscaleMask = 0x3f;
+
+        /// The front frame is presented while the back one is rendered
+        std::array<FrameBuffer, 2> mFrames;
+
+        int mFrontFrame = 0;
+
+        int mBackFrame = 1;
+
+        bool mSkipFrames = false;
+
+        /// Latched when a frame starts, so that a frame is either whole or skipped
+        bool mSkippingFrame = false;
     };
 }
\ No newline at end of file
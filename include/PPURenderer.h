@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "Utility.h"
+#include "CHRMemory.h"
+#include "PictureBus.h"
+#include "FrameBuffer.h"
+#include "ScanlineRenderer.h"
+
+namespace ANNESE {
+    /// Renders whole scanlines on its own thread while the PPU keeps the timing, the registers and the sprite 0 hit.
+    /// It keeps a copy of the PPU memory that follows the writes and the bank switches it is given, in the order
+    /// they were made, so it must be created before anything is written to the PPU memory.
+    /// Only the thread that emulates the PPU may call it
+    class PPURenderer {
+    public:
+        explicit PPURenderer(bool chrRAM);
+
+        ~PPURenderer();
+
+        PPURenderer(const PPURenderer &) = delete;
+
+        PPURenderer &operator=(const PPURenderer &) = delete;
+
+        /// A write through PPUDATA
+        void write(Address addr, Byte value);
+
+        /// The CHR pages and the name tables as they are mapped from now on
+        void setLayout(const std::array<const Byte *, 8> &chrPages, CHRMemory::NameTableMirroring mirroring);
+
+        /// The row is written from the other thread, it must stay untouched until finish returns
+        void render(const ScanlineState &line, FrameBuffer::Pixel *row);
+
+        /// Waits until everything given so far is done
+        void finish();
+
+    protected:
+        struct Command {
+            enum class Type : Byte {
+                Write,
+                Layout,
+                Render,
+            };
+
+            Type type;
+
+            Address addr;
+
+            Byte value;
+
+            CHRMemory::NameTableMirroring mirroring;
+
+            std::array<const Byte *, 8> chrPages;
+
+            ScanlineState line;
+
+            FrameBuffer::Pixel *row;
+        };
+
+        class CHRCopy;
+
+        /// About 4 frames of scanlines
+        static constexpr const std::size_t QueueSize = 1024;
+
+        /// The worker polls the queue for a while before it goes to sleep
+        static constexpr const int PollsBeforeSleep = 256;
+
+        void push(const Command &command);
+
+        void run();
+
+        void execute(const Command &command);
+
+        std::shared_ptr<CHRCopy> mCHR;
+
+        PictureBus mMemory;
+
+        ScanlineCompositor::Kernel mComposite;
+
+        /// Single producer, single consumer ring
+        std::unique_ptr<Command[]> mQueue;
+
+        /// The next command to execute, only the worker moves it
+        alignas(64) std::atomic<std::size_t> mHead{0};
+
+        /// The next free slot, only the producer moves it
+        alignas(64) std::atomic<std::size_t> mTail{0};
+
+        std::atomic<bool> mSleeping{false};
+
+        bool mStop = false;
+
+        std::mutex mMutex;
+
+        std::condition_variable mWakeUp;
+
+        /// Started last, once everything it uses is there
+        std::thread mThread;
+    };
+}
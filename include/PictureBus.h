@@ -1,8 +1,12 @@
 #pragma once
 
-
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include "Utility.h"
-#include "Mapper.h"
+#include "CHRMemory.h"
 
 namespace ANNESE {
     class PictureBus {
@@ -11,17 +15,66 @@ namespace ANNESE {
 
         virtual ~PictureBus() = default;
 
-        Byte read(Address addr) const;
+        /// The pattern tables are read several times per pixel, so they are mapped without calling the mapper
+        Byte read(Address addr) const {
+            if (addr < static_cast<Address>(MemoryMap::VRAM0)) {
+                return mCHRPages[addr >> 10][addr & 0x3ff];
+            }
+            return readVRAM(addr);
+        }
+
+        /// The 8 pixels of a pattern row given by the address of its low plane, one byte per pixel holding its
+        /// 2 bit color, the leftmost pixel in the lowest byte
+        std::uint64_t readPatternRow(Address addr) {
+            DecodedPage &page = *mDecodedCHRPages[addr >> 10];
+            std::uint64_t tile = 1ull << ((addr >> 4) & 0x3f);
+            if (!(page.valid & tile)) {
+                decodeTile(page, addr);
+            }
+            return page.rows[((addr >> 1) & 0x1f8) | (addr & 0x7)];
+        }
 
         void write(Address addr, Byte value);
 
-        bool setMapper(std::shared_ptr<Mapper> mapper);
+        bool setCHRMemory(std::shared_ptr<CHRMemory> chrMemory);
 
-        Byte readPalette(Byte paletteAddr);
+        Byte readPalette(Byte paletteAddr) const {
+            return mPalette[paletteAddr & 0x1f];
+        }
 
         void updateMirroring();
 
+        /// Maps the name tables without asking the mapper, false if the mirroring isn't supported
+        bool setMirroring(CHRMemory::NameTableMirroring mirroring);
+
+        CHRMemory::NameTableMirroring nameTableMirroring() const {
+            return mMirroring;
+        }
+
+        const std::array<const Byte *, 8> &chrPages() const {
+            return mCHRPages;
+        }
+
+        /// Changes every time the CHR pages or the name tables are remapped
+        unsigned layoutGeneration() const {
+            return mLayoutGeneration;
+        }
+
     protected:
+        /// Name tables and palettes
+        Byte readVRAM(Address addr) const;
+
+        /// The 64 tiles of a 1KB CHR page, decoded as they get used
+        struct DecodedPage {
+            std::uint64_t valid = 0;
+
+            std::array<std::uint64_t, 64 * 8> rows;
+        };
+
+        void updateCHRPages();
+
+        void decodeTile(DecodedPage &page, Address addr);
+
         std::vector<Byte> mRAM;
 
         // indices
@@ -33,9 +86,22 @@ namespace ANNESE {
 
         size_t mVRAM3;
 
-        std::vector<Byte> mPalette;
+        CHRMemory::NameTableMirroring mMirroring = CHRMemory::NameTableMirroring::Horizontal;
+
+        unsigned mLayoutGeneration = 0;
+
+        /// The 6 bit color indices, the entries shared by the background and the sprites are kept in both halves
+        std::array<Byte, 0x20> mPalette{};
+
+        std::shared_ptr<CHRMemory> mCHRMemory;
+
+        /// 1KB pages of the pattern tables
+        std::array<const Byte *, 8> mCHRPages{};
+
+        std::array<DecodedPage *, 8> mDecodedCHRPages{};
 
-        std::shared_ptr<Mapper> mMapper;
+        /// Keyed by the location of the page in the CHR memory, so that the decoded tiles survive bank switches
+        std::unordered_map<const Byte *, DecodedPage> mDecodedCHR;
 
         enum class MemoryMap : Address {
             CHRROM = 0x0,
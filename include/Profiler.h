@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "Utility.h"
+#include "CPU.h"
+
+namespace ANNESE {
+    /// Counts where the emulated time goes: executions and cycles per instruction address and PRG bank,
+    /// and cycles per call stack, tracked by JSR/RTS and interrupts.
+    /// The CPU falls back to the interpreter while a profiler is attached
+    class Profiler {
+    public:
+        Profiler();
+
+        virtual ~Profiler() = default;
+
+        /// The PRG bank is -1 for the code outside of the PRG ROM
+        void instruction(Address pc, int bank, Operation op, CycleLength cycles);
+
+        void call(Address target, int bank);
+
+        void interrupt(CPU::Interruption inter, Address handler, int bank, CycleLength cycles);
+
+        void clear();
+
+        /// One line per call stack, the format flamegraph tools accept
+        void writeFoldedStacks(std::ostream &os) const;
+
+        /// The instructions that took the most cycles, followed by the banks and the interrupt handlers
+        void writeSummary(std::ostream &os, std::size_t count) const;
+
+    protected:
+        struct Counters {
+            std::uint64_t executions = 0;
+
+            std::uint64_t cycles = 0;
+        };
+
+        struct StackNode {
+            std::size_t parent;
+
+            std::uint32_t frame;
+
+            std::uint64_t cycles;
+        };
+
+        /// The call stack is forgotten when it grows deeper than this, e.g. when the code never returns
+        static constexpr const std::size_t MaxStackDepth = 256;
+
+        static constexpr const std::uint32_t InterruptFrame = 0x80000000;
+
+        static std::uint32_t Location(Address pc, int bank);
+
+        static std::string FrameName(std::uint32_t frame);
+
+        void push(std::uint32_t frame);
+
+        void pop();
+
+        std::unordered_map<std::uint32_t, Counters> mInstructions;
+
+        std::unordered_map<int, std::uint64_t> mBankCycles;
+
+        /// Node 0 is the code that runs outside of any subroutine
+        std::vector<StackNode> mNodes;
+
+        /// Keyed by the parent node and the frame
+        std::unordered_map<std::uint64_t, std::size_t> mChildren;
+
+        std::vector<std::size_t> mStack;
+
+        std::vector<CPU::Interruption> mInterrupts;
+
+        Counters mInterruptCounters[3];
+
+        std::uint64_t mTotalCycles;
+    };
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include "Utility.h"
+
+namespace ANNESE {
+    /// Mixes the background and the sprites of a scanline into palette addresses.
+    /// Background pixels are palette addresses, 0 where transparent.
+    /// Sprite pixels are palette addresses of the front-most opaque sprite ORed with the flags below, 0 where none.
+    /// Returns whether the sprite 0 overlapped an opaque background pixel
+    class ScanlineCompositor {
+    public:
+        static constexpr const unsigned Width = 256;
+
+        static constexpr const Byte BehindBackground = 0x20;
+
+        static constexpr const Byte SpriteZero = 0x40;
+
+        using Kernel = bool (*)(const Byte *background, const Byte *sprites,
+                                bool hideEdgeBackground, bool hideEdgeSprites, Byte *paletteAddrs);
+
+        /// The reference all the others must match
+        static bool CompositeScalar(const Byte *background, const Byte *sprites,
+                                    bool hideEdgeBackground, bool hideEdgeSprites, Byte *paletteAddrs);
+
+        /// The fastest kernel the CPU supports
+        static Kernel Select();
+
+        /// Every kernel the CPU supports, from the scalar one to the fastest, so that they can be compared
+        static std::vector<Kernel> Supported();
+    };
+}
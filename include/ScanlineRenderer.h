@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "Utility.h"
+#include "FrameBuffer.h"
+#include "ScanlineCompositor.h"
+
+namespace ANNESE {
+    /// What the picture of a scanline depends on besides the PPU memory, as it was when the scanline started
+    struct ScanlineState {
+        /// The 4 OAM bytes of a sprite and its index
+        struct Sprite {
+            Byte index;
+
+            Byte y;
+
+            Byte tile;
+
+            Byte attribute;
+
+            Byte x;
+        };
+
+        int scanline;
+
+        Address dataAddress;
+
+        Byte fineXScroll;
+
+        /// The pattern tables, 0 or 0x1000
+        Address bgPage;
+
+        Address sprPage;
+
+        bool longSprites;
+
+        bool showBackground;
+
+        bool showSprites;
+
+        bool hideEdgeBackground;
+
+        bool hideEdgeSprites;
+
+        Byte grayscaleMask;
+
+        FrameBuffer::Pixel emphasis;
+
+        /// The sprites found on the previous scanline, in the order of priority
+        std::size_t spriteCount;
+
+        std::array<Sprite, 8> sprites;
+    };
+
+    /// Produces a scanline in one pass. The memory is a PictureBus or anything that reads like one
+    class ScanlineRenderer {
+    public:
+        /// Returns whether the sprite 0 hit the background
+        template<typename Memory>
+        static bool Render(const ScanlineState &line, Memory &memory, ScanlineCompositor::Kernel composite,
+                           FrameBuffer::Pixel *row);
+
+        /// Palette addresses of the front-most opaque sprite pixels,
+        /// with the ScanlineCompositor priority and sprite 0 flags, 0 where none
+        template<typename Memory>
+        static void RasterizeSprites(const ScanlineState &line, Memory &memory, Byte *sprites);
+
+        static void IncrementCoarseX(Address &dataAddress) {
+            if ((dataAddress & 0x001F) == 31) {    // if coarse X == 31
+                dataAddress &= ~0x001F;    // coarse X = 0
+                dataAddress ^= 0x0400;     // switch horizontal nametable
+            } else {
+                dataAddress += 1;  // increment coarse X
+            }
+        }
+    };
+
+    template<typename Memory>
+    bool ScanlineRenderer::Render(const ScanlineState &line, Memory &memory, ScanlineCompositor::Kernel composite,
+                                  FrameBuffer::Pixel *row) {
+        constexpr int Width = ScanlineCompositor::Width;
+        //Palette entries of every pixel, 0 where transparent
+        Byte background[Width] = {};
+
+        if (line.showBackground) {
+            Address dataAddress = line.dataAddress;
+            for (int x = 0; x < Width;) {
+                Address addr = Address(0x2000) | (dataAddress & Address(0x0FFF));
+                Byte tile = memory.read(addr);
+
+                addr = (tile * 16) + ((dataAddress >> 12) & Address(0x7));
+                addr |= line.bgPage;
+                std::uint64_t pattern = memory.readPatternRow(addr);
+
+                addr = Address(0x23C0) | (dataAddress & 0x0C00) | ((dataAddress >> 4) & 0x38)
+                       | ((dataAddress >> 2) & 0x07);
+                int shift = ((dataAddress >> 4) & 4) | (dataAddress & 2);
+                Byte palette = ((memory.read(addr) >> shift) & 0x3) << 2;
+
+                int xFine = (line.fineXScroll + x) % 8;
+                for (; xFine < 8 && x < Width; ++xFine, ++x) {
+                    Byte color = static_cast<Byte>(pattern >> (xFine * 8));
+                    background[x] = color ? color | palette : 0;
+                }
+                //Only the tiles shown to their last pixel advance coarse X
+                if (xFine == 8) {
+                    IncrementCoarseX(dataAddress);
+                }
+            }
+        }
+
+        Byte sprites[Width];
+        RasterizeSprites(line, memory, sprites);
+
+        //The left edge is masked by the compositor
+        Byte paletteAddrs[Width];
+        bool spriteZeroHit = composite(background, sprites, line.hideEdgeBackground, line.hideEdgeSprites,
+                                       paletteAddrs);
+        //The palette can't change during the line, so every address is resolved once
+        FrameBuffer::Pixel colors[0x20];
+        for (Byte addr = 0; addr < 0x20; ++addr) {
+            colors[addr] = (memory.readPalette(addr) & line.grayscaleMask) | line.emphasis;
+        }
+        for (int x = 0; x < Width; ++x) {
+            row[x] = colors[paletteAddrs[x]];
+        }
+        return spriteZeroHit;
+    }
+
+    template<typename Memory>
+    void ScanlineRenderer::RasterizeSprites(const ScanlineState &line, Memory &memory, Byte *sprites) {
+        constexpr int Width = ScanlineCompositor::Width;
+        std::fill(sprites, sprites + Width, Byte(0));
+        if (!line.showSprites) {
+            return;
+        }
+        int length = line.longSprites ? 16 : 8;
+        //The sprites are in the order of priority, so a pixel is never overwritten once taken
+        for (std::size_t i = 0; i < line.spriteCount; ++i) {
+            const ScanlineState::Sprite &sprite = line.sprites[i];
+            int yOffset = (line.scanline - Byte(sprite.y + 1)) % length;
+            if ((sprite.attribute & 0x80) != 0) {
+                yOffset ^= (length - 1);
+            }
+            Address addr = 0;
+            if (!line.longSprites) {
+                addr = sprite.tile * Address(16) + yOffset;
+                addr += line.sprPage;
+            } else {
+                yOffset = (yOffset & 7) | ((yOffset & 8) << 1);
+                addr = (sprite.tile >> 1) * Address(32) + yOffset;
+                addr |= (sprite.tile & 1) << 12;
+            }
+            std::uint64_t pattern = memory.readPatternRow(addr);
+
+            Byte flags = 0x10 | (sprite.attribute & 0x3) << 2 |
+                         (sprite.attribute & ScanlineCompositor::BehindBackground) |
+                         (sprite.index == 0 ? ScanlineCompositor::SpriteZero : 0);
+            for (int column = 0; column < 8; ++column) {
+                int x = sprite.x + column;
+                if (x >= Width) {
+                    break;
+                }
+                if (sprites[x]) {
+                    continue;
+                }
+                int pixel = (sprite.attribute & 0x40) ? column ^ 7 : column;
+                Byte color = static_cast<Byte>(pattern >> (pixel * 8));
+                if (color) {
+                    sprites[x] = flags | color;
+                }
+            }
+        }
+    }
+}
@@ -2,22 +2,28 @@
 
 #include <SFML/Graphics/Drawable.hpp>
 #include <SFML/Graphics/Color.hpp>
-#include <SFML/Graphics/VertexArray.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <array>
+#include <vector>
+#include "FrameBuffer.h"
+#include "TripleBuffer.h"
+#include "VideoSink.h"
 
 namespace ANNESE {
-    struct Pixel {
-        int x;
-
-        int y;
-    };
-
-    class Screen : public sf::Drawable {
+    /// The picture is kept in a texture of one texel per pixel, drawn as a single scaled quad.
+    /// The pictures may be set from another thread than the one drawing the screen
+    class Screen : public sf::Drawable, public VideoSink {
     public:
         Screen(sf::Vector2i screenSize, float pixelScale, sf::Color filling = sf::Color::White);
 
         virtual ~Screen() = default;
 
-        void setPixel(Pixel pixel, sf::Color color);
+        /// Converts a whole picture of palette indices to colors and publishes it
+        void setPicture(const FrameBuffer &picture) override;
+
+        /// The colors of the newest picture, row by row. Only the thread drawing the screen may call it
+        const std::vector<sf::Color> &pixels();
 
     protected:
         void draw(sf::RenderTarget &target, sf::RenderStates states) const override;
@@ -26,6 +32,20 @@ namespace ANNESE {
 
         float mPixelScale;
 
-        sf::VertexArray mVertices;
+        /// Picks the newest picture up, if there is one
+        void updatePicture() const;
+
+        /// RGBA, as the texture takes them
+        mutable TripleBuffer<std::vector<sf::Color>> mPictures;
+
+        /// Updated from the front picture once per picture, when it is drawn
+        mutable sf::Texture mTexture;
+
+        mutable bool mTextureOutdated = true;
+
+        sf::Sprite mSprite;
+
+        /// The frame buffer pixels resolved to colors, with the emphasis applied
+        std::array<sf::Color, FrameBuffer::ColorCount> mColors;
     };
 }
\ No newline at end of file
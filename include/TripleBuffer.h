@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+namespace ANNESE {
+    /// Hands values over from one thread to another without locks and without either ever waiting.
+    /// The writer fills the back buffer and publishes it, the reader picks the newest published one up.
+    /// Values published before the reader gets to them are dropped
+    template<typename T>
+    class TripleBuffer {
+    public:
+        TripleBuffer() = default;
+
+        explicit TripleBuffer(const T &value) {
+            mBuffers.fill(value);
+        }
+
+        /// Only the writer may touch it
+        T &back() {
+            return mBuffers[mBack];
+        }
+
+        void publish() {
+            mBack = mMiddle.exchange(mBack | Fresh, std::memory_order_acq_rel) & Index;
+        }
+
+        /// Switches the front buffer to the newest published one, false if there is none since the last time
+        bool update() {
+            if (!(mMiddle.load(std::memory_order_relaxed) & Fresh)) {
+                return false;
+            }
+            mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & Index;
+            return true;
+        }
+
+        /// Only the reader may touch it
+        const T &front() const {
+            return mBuffers[mFront];
+        }
+
+    protected:
+        static constexpr const unsigned Index = 0x3;
+
+        /// Set on the middle buffer when it holds a value the reader hasn't seen
+        static constexpr const unsigned Fresh = 0x4;
+
+        std::array<T, 3> mBuffers{};
+
+        unsigned mBack = 0;
+
+        unsigned mFront = 1;
+
+        std::atomic<unsigned> mMiddle{2};
+    };
+}
@@ -13,6 +13,9 @@ namespace ANNESE {
 
     using CycleLength = int;
 
+    /// A point in emulated time counted from the power on, wide enough to never overflow
+    using CycleCount = std::int64_t;
+
     constexpr Address operator "" _a(unsigned long long v) {
         return static_cast<Address>(v);
     }
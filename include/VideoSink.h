@@ -0,0 +1,13 @@
+#pragma once
+
+#include "FrameBuffer.h"
+
+namespace ANNESE {
+    /// Where the PPU sends every complete picture, on the thread that emulates it
+    class VideoSink {
+    public:
+        virtual ~VideoSink() = default;
+
+        virtual void setPicture(const FrameBuffer &picture) = 0;
+    };
+}
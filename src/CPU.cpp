@@ -3,32 +3,44 @@
 //
 
 #include <cassert>
+#include <algorithm>
 #include <iomanip>
 #include "../include/CPU.h"
+#include "../include/Profiler.h"
 #include "../include/TeeLog.hpp"
 
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "OCDFAInspection"
 
-#define FlagC mFlags[0]
-
-#define FlagZ mFlags[1]
-
-#define FlagI mFlags[2]
-
-#define FlagD mFlags[3]
-
-#define FlagB mFlags[4]
-
-#define FlagUnused mFlags[5]
-
-#define FlagV mFlags[6]
-
-#define FlagN mFlags[7]
+#if defined(__GNUC__) || defined(__clang__)
+#define ANNESE_COMPUTED_GOTO 1
+#else
+#define ANNESE_COMPUTED_GOTO 0
+#endif
+
+//Must list every opcode in ascending order
+#define ANNESE_OPCODES(X) \
+    X(0x00) X(0x01) X(0x02) X(0x03) X(0x04) X(0x05) X(0x06) X(0x07) X(0x08) X(0x09) X(0x0a) X(0x0b) X(0x0c) X(0x0d) X(0x0e) X(0x0f) \
+    X(0x10) X(0x11) X(0x12) X(0x13) X(0x14) X(0x15) X(0x16) X(0x17) X(0x18) X(0x19) X(0x1a) X(0x1b) X(0x1c) X(0x1d) X(0x1e) X(0x1f) \
+    X(0x20) X(0x21) X(0x22) X(0x23) X(0x24) X(0x25) X(0x26) X(0x27) X(0x28) X(0x29) X(0x2a) X(0x2b) X(0x2c) X(0x2d) X(0x2e) X(0x2f) \
+    X(0x30) X(0x31) X(0x32) X(0x33) X(0x34) X(0x35) X(0x36) X(0x37) X(0x38) X(0x39) X(0x3a) X(0x3b) X(0x3c) X(0x3d) X(0x3e) X(0x3f) \
+    X(0x40) X(0x41) X(0x42) X(0x43) X(0x44) X(0x45) X(0x46) X(0x47) X(0x48) X(0x49) X(0x4a) X(0x4b) X(0x4c) X(0x4d) X(0x4e) X(0x4f) \
+    X(0x50) X(0x51) X(0x52) X(0x53) X(0x54) X(0x55) X(0x56) X(0x57) X(0x58) X(0x59) X(0x5a) X(0x5b) X(0x5c) X(0x5d) X(0x5e) X(0x5f) \
+    X(0x60) X(0x61) X(0x62) X(0x63) X(0x64) X(0x65) X(0x66) X(0x67) X(0x68) X(0x69) X(0x6a) X(0x6b) X(0x6c) X(0x6d) X(0x6e) X(0x6f) \
+    X(0x70) X(0x71) X(0x72) X(0x73) X(0x74) X(0x75) X(0x76) X(0x77) X(0x78) X(0x79) X(0x7a) X(0x7b) X(0x7c) X(0x7d) X(0x7e) X(0x7f) \
+    X(0x80) X(0x81) X(0x82) X(0x83) X(0x84) X(0x85) X(0x86) X(0x87) X(0x88) X(0x89) X(0x8a) X(0x8b) X(0x8c) X(0x8d) X(0x8e) X(0x8f) \
+    X(0x90) X(0x91) X(0x92) X(0x93) X(0x94) X(0x95) X(0x96) X(0x97) X(0x98) X(0x99) X(0x9a) X(0x9b) X(0x9c) X(0x9d) X(0x9e) X(0x9f) \
+    X(0xa0) X(0xa1) X(0xa2) X(0xa3) X(0xa4) X(0xa5) X(0xa6) X(0xa7) X(0xa8) X(0xa9) X(0xaa) X(0xab) X(0xac) X(0xad) X(0xae) X(0xaf) \
+    X(0xb0) X(0xb1) X(0xb2) X(0xb3) X(0xb4) X(0xb5) X(0xb6) X(0xb7) X(0xb8) X(0xb9) X(0xba) X(0xbb) X(0xbc) X(0xbd) X(0xbe) X(0xbf) \
+    X(0xc0) X(0xc1) X(0xc2) X(0xc3) X(0xc4) X(0xc5) X(0xc6) X(0xc7) X(0xc8) X(0xc9) X(0xca) X(0xcb) X(0xcc) X(0xcd) X(0xce) X(0xcf) \
+    X(0xd0) X(0xd1) X(0xd2) X(0xd3) X(0xd4) X(0xd5) X(0xd6) X(0xd7) X(0xd8) X(0xd9) X(0xda) X(0xdb) X(0xdc) X(0xdd) X(0xde) X(0xdf) \
+    X(0xe0) X(0xe1) X(0xe2) X(0xe3) X(0xe4) X(0xe5) X(0xe6) X(0xe7) X(0xe8) X(0xe9) X(0xea) X(0xeb) X(0xec) X(0xed) X(0xee) X(0xef) \
+    X(0xf0) X(0xf1) X(0xf2) X(0xf3) X(0xf4) X(0xf5) X(0xf6) X(0xf7) X(0xf8) X(0xf9) X(0xfa) X(0xfb) X(0xfc) X(0xfd) X(0xfe) X(0xff)
 
 namespace ANNESE {
     CPU::CPU(std::shared_ptr<MainBus> mainBus)
-            : mMainBus(std::move(mainBus)) {
+            : mMainBus(std::move(mainBus)),
+              mRAM(mMainBus->RAM()) {
     }
 
     void CPU::reset() {
@@ -36,58 +48,227 @@ namespace ANNESE {
     }
 
     void CPU::reset(Address startAddr) {
-        mSkipCycles = mCycles = 0;
-        mRegA = mRegX = mRegY = 0;
-        FlagI = true;
-        FlagC = FlagD = FlagN = FlagV = FlagZ = false;
-        FlagUnused = true;
-        mRegPC = startAddr;
-        mRegSP = 0xfd;  // Documented startup state;
+        mCycles = 0;
+        mPendingNMI = mHalted = false;
+        mRegs.A = mRegs.X = mRegs.Y = 0;
+        setStatus(FlagI | FlagUnused);
+        mRegs.PC = startAddr;
+        mRegs.SP = 0xfd;  // Documented startup state;
     }
 
     void CPU::interrupt(CPU::Interruption inter) {
-        if (FlagI && inter != Interruption::NMI && inter != Interruption::BRK) {
+        if ((mRegs.status & FlagI) && inter != Interruption::NMI && inter != Interruption::BRK) {
             return;
         }
 
         if (inter == Interruption::BRK) {
-            ++mRegPC;
+            ++mRegs.PC;
         }
 
-        pushToStack(static_cast<Byte>(mRegPC >> 8));
-        pushToStack(static_cast<Byte>(mRegPC));
-        FlagB = inter == Interruption::BRK;
+        pushToStack(static_cast<Byte>(mRegs.PC >> 8));
+        pushToStack(static_cast<Byte>(mRegs.PC));
+        mRegs.status = (mRegs.status & ~FlagB) | (inter == Interruption::BRK ? FlagB : 0);
 
-        pushToStack(static_cast<Byte>(mFlags.to_ulong()));
+        pushToStack(status());
 
-        FlagI = true;
+        mRegs.status |= FlagI;
         switch (inter) {
             case Interruption::IRQ:
                 [[fallthrough]]
             case Interruption::BRK:
-                mRegPC = readAddress(IRQVector);
+                mRegs.PC = readAddress(IRQVector);
                 break;
             case Interruption::NMI:
-                mRegPC = readAddress(NMIVector);
+                mRegs.PC = readAddress(NMIVector);
+        }
+        mCycles += 7;
+
+        if (mProfiler) {
+            mProfiler->interrupt(inter, mRegs.PC, mMainBus->prgBank(mRegs.PC), 7);
+        }
+    }
+
+    void CPU::serveInterrupts() {
+        if (mPendingNMI) {
+            mPendingNMI = false;
+            interrupt(Interruption::NMI);
         }
-        mSkipCycles += 7;
     }
 
     void CPU::step() {
-        ++mCycles;
+        serveInterrupts();
+
+        Address pc = mRegs.PC;
+        CycleCount start = mCycles;
+        Byte opcode = mMainBus->read(mRegs.PC++);
+        //Just this one
+        execute(opcode, mCycles);
+
+        if (mProfiler) {
+            profile(pc, opcode, static_cast<CycleLength>(mCycles - start));
+        }
+    }
 
-        if (--mSkipCycles > 0) {
+    void CPU::profile(Address pc, Byte opcode, CycleLength cycles) {
+        Operation op = OpcodeTable[opcode].operation;
+        mProfiler->instruction(pc, mMainBus->prgBank(pc), op, cycles);
+        if (op == Operation::JSR) {
+            mProfiler->call(mRegs.PC, mMainBus->prgBank(mRegs.PC));
+        }
+    }
+
+    void CPU::runUntil(CycleCount cycle) {
+        if (mHalted) {
+            mCycles = std::max(mCycles, cycle);
             return;
         }
+        while (mCycles < cycle && !mHalted) {
+            if (mProfiler) {
+                step();
+            } else if (mExecutionMode == ExecutionMode::Interpreter) {
+                serveInterrupts();
+                execute(mMainBus->read(mRegs.PC++), cycle);
+            } else if (mRegs.PC >= 0x8000) {
+                runBlock(cycle);
+            } else {
+                //Code running from the RAM may be modified at any time, so it is always interpreted
+                step();
+            }
+        }
+    }
+
+    void CPU::setExecutionMode(ExecutionMode mode) {
+        if (mode != mExecutionMode) {
+            //Blocks are decoded differently for every mode
+            mBlocks.clear();
+            mBlockSlots.clear();
+            mExecutionMode = mode;
+        }
+    }
+
+    void CPU::runBlock(CycleCount cycle) {
+        serveInterrupts();
+
+        const BasicBlock &block = findBlock(mRegs.PC);
+        if (block.instructions.empty()) {
+            //The first instruction crosses the end of the chunk
+            step();
+            return;
+        }
+
+        unsigned generation = mMainBus->prgBankGeneration();
+        Address start = mRegs.PC;
+        CycleCount startCycle = mCycles;
+        for (const DecodedInstruction &instruction : block.instructions) {
+            mRegs.PC += instruction.length;
+            (this->*instruction.handler)(instruction.operand);
+            mCycles += instruction.cycles;
+            //The rest of the block may be gone after a bank switch
+            if (mCycles >= cycle || mPendingNMI || mHalted || mMainBus->prgBankGeneration() != generation) {
+                return;
+            }
+        }
+
+        if (block.idle && mRegs.PC == start) {
+            skipIdleLoop(block, startCycle, cycle);
+        }
+    }
+
+    void CPU::skipIdleLoop(const BasicBlock &block, CycleCount iterationStart, CycleCount cycle) {
+        IdleLoop iteration;
+        iteration.PC = mRegs.PC;
+        iteration.A = mRegs.A;
+        iteration.X = mRegs.X;
+        iteration.Y = mRegs.Y;
+        iteration.SP = mRegs.SP;
+        iteration.status = status();
+        iteration.cycles = mCycles;
+
+        //The previous iteration must have ended right where this one started and left the same state,
+        //then the loop keeps doing exactly the same until the memory it reads changes
+        if (mIdleLoop.cycles == iterationStart && mIdleLoop.PC == iteration.PC && mIdleLoop.A == iteration.A &&
+            mIdleLoop.X == iteration.X && mIdleLoop.Y == iteration.Y && mIdleLoop.SP == iteration.SP &&
+            mIdleLoop.status == iteration.status) {
+            //The RAM only changes in the NMI handler, which can not start before the cycle
+            CycleCount horizon = cycle;
+            if (block.pollsPPUStatus) {
+                horizon = mPPUStatusHorizonCallback ? std::min(horizon, mPPUStatusHorizonCallback()) : mCycles;
+            }
+            //The last iteration before the horizon runs as usual
+            CycleCount length = mCycles - iterationStart;
+            if (horizon - mCycles > length) {
+                mCycles += (horizon - mCycles - 1) / length * length;
+                iteration.cycles = mCycles;
+            }
+        }
+        mIdleLoop = iteration;
+    }
+
+    const CPU::BasicBlock &CPU::findBlock(Address pc) {
+        if (mBlockSlots.empty()) {
+            mBlockSlots.resize(0x8000);
+        }
+
+        BlockSlot &slot = mBlockSlots[pc & 0x7fff];
+        unsigned generation = mMainBus->prgBankGeneration();
+        if (slot.block && slot.generation == generation) {
+            return *slot.block;
+        }
+
+        const Byte *code = mMainBus->getPRGPtr(pc);
+        auto it = mBlocks.find(code);
+        if (it == mBlocks.end()) {
+            it = mBlocks.emplace(code, decodeBlock(code, pc)).first;
+        }
+        slot.block = &it->second;
+        slot.generation = generation;
+        return it->second;
+    }
 
-        Byte opcode = mMainBus->read(mRegPC++);
+    CPU::BasicBlock CPU::decodeBlock(const Byte *code, Address pc) const {
+        BasicBlock block;
+        std::size_t available = BlockChunkSize - (pc & (BlockChunkSize - 1));
+        std::size_t offset = 0;
+        bool idle = true;
+        while (block.instructions.size() < MaxBlockLength) {
+            const Byte opcode = code[offset];
+            const OpcodeInfo &info = OpcodeTable[opcode];
+            if (offset + info.length > available) {
+                break;
+            }
+
+            Address operand = 0;
+            if (info.length > 1) {
+                operand = code[offset + 1];
+            }
+            if (info.length > 2) {
+                operand |= code[offset + 2] << 8;
+            }
+            //The operand is known at this point, so an access that can only hit the internal RAM skips the bus
+            bool inRAM = mExecutionMode == ExecutionMode::Compiled && IsAbsolute(info.mode) &&
+                         operand + (info.mode == AddressingMode::Absolute ? 0 : 0xff) < 0x2000;
+            Handler handler = inRAM ? RAMHandlers[opcode] : Handlers[opcode];
+            block.instructions.push_back({handler, operand, info.length, static_cast<Byte>(info.cycles)});
+
+            offset += info.length;
+            if (ChangesControlFlow(info.operation)) {
+                block.idle = idle && (info.mode == AddressingMode::Relative || info.operation == Operation::JMP);
+                break;
+            }
 
-        Operation operation;
-        AddressingMode addressingMode;
-        CycleLength cycleLength;
-        std::tie(operation, addressingMode, cycleLength) = OpcodeDecoder::Decode(opcode);
-        execute(operation, addressingMode);
-        mSkipCycles += cycleLength;
+            if (!IsIdempotentRead(info.operation)) {
+                idle = false;
+            } else if (info.mode == AddressingMode::Absolute && operand == static_cast<Address>(IORegisters::PPUStatus)) {
+                block.pollsPPUStatus = true;
+            } else if (!(info.mode == AddressingMode::None || info.mode == AddressingMode::Immediate ||
+                         info.mode == AddressingMode::ZeroPage || info.mode == AddressingMode::IndexedX ||
+                         info.mode == AddressingMode::Indexed ||
+                         (IsAbsolute(info.mode) &&
+                          operand + (info.mode == AddressingMode::Absolute ? 0 : 0xff) < 0x2000))) {
+                idle = false;
+            }
+        }
+        return block;
     }
 
     Address CPU::readAddress(Address addr) {
@@ -95,536 +276,394 @@ namespace ANNESE {
     }
 
     void CPU::pushToStack(Byte value) {
-        mMainBus->write(0x100_a | mRegSP, value);
-        --mRegSP;
+        mMainBus->write(0x100_a | mRegs.SP, value);
+        --mRegs.SP;
     }
 
     Byte CPU::pullFromStack() {
-        return mMainBus->read(0x100_a | ++mRegSP);
+        return mMainBus->read(0x100_a | ++mRegs.SP);
     }
 
     void CPU::setPageCrossed(Address a, Address b, CycleLength inc) {
         if ((a & 0xff00) != (b & 0xff00)) {
-            mSkipCycles += inc;
+            mCycles += inc;
         }
     }
 
     void CPU::setZN(Byte value) {
-        FlagZ = !value;
-        FlagN = (value & 0x80) != 0;
+        mRegs.zero = mRegs.negative = value;
     }
 
-    void CPU::execute(Operation op, AddressingMode mode) {
-        switch (op) {
-            case Operation::BIT: [[fallthrough]]
-            case Operation::STY: [[fallthrough]]
-            case Operation::LDY: [[fallthrough]]
-            case Operation::CPY: [[fallthrough]]
-            case Operation::CPX: [[fallthrough]]
-            case Operation::ORA: [[fallthrough]]
-            case Operation::AND: [[fallthrough]]
-            case Operation::EOR: [[fallthrough]]
-            case Operation::ADC: [[fallthrough]]
-            case Operation::STA: [[fallthrough]]
-            case Operation::LDA: [[fallthrough]]
-            case Operation::CMP: [[fallthrough]]
-            case Operation::SBC: [[fallthrough]]
-            case Operation::ASL: [[fallthrough]]
-            case Operation::ROL: [[fallthrough]]
-            case Operation::LSR: [[fallthrough]]
-            case Operation::ROR: [[fallthrough]]
-            case Operation::STX: [[fallthrough]]
-            case Operation::LDX: [[fallthrough]]
-            case Operation::DEC: [[fallthrough]]
-            case Operation::INC:
-                execute1(op, mode);
-                break;
-            case Operation::NOP:
-                break;
-            case Operation::BRK:
-                interrupt(Interruption::BRK);
-                break;
-            case Operation::JSR:
-                pushToStack(static_cast<Byte>((mRegPC + 1) >> 8));
-                pushToStack(static_cast<Byte>((mRegPC + 1)));
-                mRegPC = readAddress(mRegPC);
-                break;
-            case Operation::RTI: {
-                mFlags = pullFromStack();
-                mRegPC = pullFromStack();
-                mRegPC |= pullFromStack() << 8;
-                break;
-            }
-            case Operation::RTS:
-                mRegPC = pullFromStack();
-                mRegPC |= pullFromStack() << 8;
-                ++mRegPC;
-                break;
-            case Operation::JMP:
-                mRegPC = readAddress(mRegPC);
-                break;
-            case Operation::JMPI: {
-                Address location = readAddress(mRegPC);
-                //6502 has a bug such that the when the vector of an indirect address begins at the last byte of a page,
-                //the second byte is fetched from the beginning of that page rather than the beginning of the next
-                //Recreating here:
-                Address page = location & 0xff00_a;
-                mRegPC = mMainBus->read(location) |
-                         mMainBus->read(page | ((location + 1_a) & 0xff_a)) << 8;
-                break;
-            }
-            case Operation::PHP: {
-                FlagB = true;
-                pushToStack(static_cast<Byte>(mFlags.to_ulong()));
-                break;
-            }
-            case Operation::PLP:{
-                mFlags = pullFromStack();
-                break;
-            }
-            case Operation::PHA:
-                pushToStack(mRegA);
-                break;
-            case Operation::PLA:
-                mRegA = pullFromStack();
-                setZN(mRegA);
-                break;
-            case Operation::DEY:
-                --mRegY;
-                setZN(mRegY);
-                break;
-            case Operation::DEX:
-                --mRegX;
-                setZN(mRegX);
-                break;
-            case Operation::TAY:
-                mRegY = mRegA;
-                setZN(mRegY);
-                break;
-            case Operation::INY:
-                ++mRegY;
-                setZN(mRegY);
-                break;
-            case Operation::INX:
-                ++mRegX;
-                setZN(mRegX);
-                break;
-            case Operation::CLC:
-                FlagC = false;
-                break;
-            case Operation::SEC:
-                FlagC = true;
-                break;
-            case Operation::CLI:
-                FlagI = false;
-                break;
-            case Operation::SEI:
-                FlagI = true;
-                break;
-            case Operation::CLD:
-                FlagD = false;
-                break;
-            case Operation::SED:
-                FlagD = true;
-                break;
-            case Operation::TYA:
-                mRegA = mRegY;
-                setZN(mRegA);
-                break;
-            case Operation::CLV:
-                FlagV = false;
-                break;
-            case Operation::TXA:
-                mRegA = mRegX;
-                setZN(mRegA);
-                break;
-            case Operation::TXS:
-                mRegSP = mRegX;
-                break;
-            case Operation::TAX:
-                mRegX = mRegA;
-                setZN(mRegX);
-                break;
-            case Operation::TSX:
-                mRegX = mRegSP;
-                setZN(mRegX);
-                break;
+    Byte CPU::status() const {
+        return mRegs.status | mRegs.carry | (mRegs.zero ? 0 : FlagZ) | (mRegs.overflow & 0x80) >> 1 |
+               (mRegs.negative & 0x80);
+    }
 
-            case Operation::BCC: [[fallthrough]]
-            case Operation::BCS: [[fallthrough]]
-            case Operation::BEQ: [[fallthrough]]
-            case Operation::BMI: [[fallthrough]]
-            case Operation::BPL: [[fallthrough]]
-            case Operation::BNE: [[fallthrough]]
-            case Operation::BVC: [[fallthrough]]
-            case Operation::BVS:
-                executeBranch(op);
-        }
+    void CPU::setStatus(Byte value) {
+        mRegs.status = value & (FlagI | FlagD | FlagB | FlagUnused);
+        mRegs.carry = value & FlagC;
+        mRegs.zero = !(value & FlagZ);
+        mRegs.overflow = value << 1;
+        mRegs.negative = value;
     }
 
-    void CPU::executeBranch(Operation op) {
-        bool branch;
-        switch (op) {
-            case Operation::BCC:
-                branch = FlagC == 0;
-                break;
-            case Operation::BCS:
-                branch = FlagC == 1;
-                break;
-            case Operation::BNE:
-                branch = FlagZ == 0;
-                break;
-            case Operation::BEQ:
-                branch = FlagZ == 1;
-                break;
-            case Operation::BPL:
-                branch = FlagN == 0;
-                break;
-            case Operation::BMI:
-                branch = FlagN == 1;
-                break;
-            case Operation::BVC:
-                branch = FlagV == 0;
-                break;
-            case Operation::BVS:
-                branch = FlagV == 1;
-                break;
-            default:
-                assert(false);
-        }
-        if (branch) {
-            SByte offset = mMainBus->read(mRegPC++);
-            ++mSkipCycles;
-            Address newPC = mRegPC + offset;
-            setPageCrossed(mRegPC, newPC, 2);
-            mRegPC = newPC;
+    template<bool InRAM>
+    Byte CPU::readMemory(Address addr) {
+        if constexpr (InRAM) {
+            return mRAM[addr & 0x7ff];
         } else {
-            ++mRegPC;
+            return mMainBus->read(addr);
         }
     }
 
-    void CPU::execute1(Operation op, AddressingMode mode) {
-        Address location = 0;
-        switch (mode) {
-            case AddressingMode::IndexedIndirectX: {
-                Byte zeroAddr = mRegX + mMainBus->read(mRegPC++);
-                location = mMainBus->read(zeroAddr & 0xff_a) | mMainBus->read((zeroAddr + 1_a) & 0xff_a) << 8;
-                break;
-            }
-            case AddressingMode::ZeroPage:
-                location = mMainBus->read(mRegPC++);
-                break;
-            case AddressingMode::Immediate:
-                location = mRegPC++;
-                break;
-            case AddressingMode::Absolute:
-                location = readAddress(mRegPC);
-                mRegPC += 2;
-                break;
-            case AddressingMode::IndirectY: {
-                Byte zeroAddr = mMainBus->read(mRegPC++);
-                location = mMainBus->read(zeroAddr & 0xff_a) | mMainBus->read((zeroAddr + 1_a) & 0xff_a) << 8;
-                if (op != Operation::STA) {
-                    setPageCrossed(location, location + mRegY);
-                }
-                location += mRegY;
-                break;
-            }
-            case AddressingMode::IndexedX:
-                location = (mMainBus->read(mRegPC++) + mRegX) & 0xff_a;
-                break;
-            case AddressingMode::AbsoluteY:
-                location = readAddress(mRegPC);
-                mRegPC += 2;
-                if (op != Operation::STA) {
-                    setPageCrossed(location, location + mRegY);
-                }
-                location += mRegY;
-                break;
-            case AddressingMode::AbsoluteX:
-                location = readAddress(mRegPC);
-                mRegPC += 2;
-                if (op != Operation::STA) {
-                    setPageCrossed(location, location + mRegX);
-                }
-                location += mRegX;
-                break;
-            case AddressingMode::Accumulator:
-                break;
-            case AddressingMode::Indexed: {
-                Byte index = (op == Operation::LDX || op == Operation::STX) ? mRegY : mRegX;
-                location = (mMainBus->read(mRegPC++) + index) & Address(0xff);
-                break;
-            }
-            case AddressingMode::AbsoluteIndexed: {
-                location = readAddress(mRegPC);
-                mRegPC += 2;
-                Byte index = (op == Operation::LDX || op == Operation::STX) ? mRegY : mRegX;
-                setPageCrossed(location, location + index);
-                location += index;
-                break;
-            }
-            default:
-                assert(false);
+    template<bool InRAM>
+    void CPU::writeMemory(Address addr, Byte value) {
+        if constexpr (InRAM) {
+            mRAM[addr & 0x7ff] = value;
+        } else {
+            mMainBus->write(addr, value);
         }
+    }
 
-        switch (op) {
-            case Operation::ORA:
-                mRegA |= mMainBus->read(location);
-                setZN(mRegA);
-                break;
-            case Operation::AND:
-                mRegA &= mMainBus->read(location);
-                setZN(mRegA);
-                break;
-            case Operation::EOR:
-                mRegA ^= mMainBus->read(location);
-                setZN(mRegA);
-                break;
-            case Operation::ADC: {
-                Byte operand = mMainBus->read(location);
-                ExtendedByte sum = mRegA + operand + FlagC;
-                // Unsigned overflow
-                FlagC = (sum & 0x100) != 0;
-                // Signed overflow, would only happen if the sign of sum is
-                // different from both the operands
-                FlagV = ((mRegA ^ sum) & (operand ^ sum) & 0x80) != 0;
-                mRegA = static_cast<Byte>(sum);
-                setZN(mRegA);
-                break;
-            }
-            case Operation::STA:
-                mMainBus->write(location, mRegA);
-                break;
-            case Operation::LDA:
-                mRegA = mMainBus->read(location);
-                setZN(mRegA);
-                break;
-            case Operation::CMP: {
-                ExtendedByte diff = mRegA - mMainBus->read(location);
-                FlagC = !(diff & 0x100);
-                setZN(static_cast<Byte>(diff));
-                break;
-            }
-            case Operation::SBC: {
-                ExtendedByte subtrahend = mMainBus->read(location);
-                //High carry means "no borrow", thus negate and subtract
-                ExtendedByte diff = mRegA - subtrahend - !FlagC;
-                // If the ninth bit is 1, the resulting number is negative => borrow => low carry
-                FlagC = !(diff & 0x100);
-                // Same as ADC, except instead of the subtrahend,
-                // substitute with it's one complement
-                FlagV = ((mRegA ^ diff) & (~subtrahend ^ diff) & 0x80) != 0;
-                mRegA = static_cast<Byte>(diff);
-                setZN(static_cast<Byte>(diff));
-                break;
-            }
-            case Operation::ASL:
-                [[fallthrough]]
-            case Operation::ROL: {
-                bool oldC = FlagC;
-                bool bit0 = (oldC && (op == Operation::ROL));
-                if (mode == AddressingMode::Accumulator) {
-                    FlagC = (mRegA & 0x80) != 0;
-                    mRegA <<= 1;
-                    // If Rotating, set the bit-0 to the the previous carry
-                    mRegA = mRegA | bit0;
-                    setZN(mRegA);
-                } else {
-                    ExtendedByte operand = mMainBus->read(location);
-                    FlagC = (operand & 0x80) != 0;
-                    operand = operand << 1 | bit0;
-                    setZN(static_cast<Byte>(operand));
-                    mMainBus->write(location, static_cast<Byte>(operand));
-                }
-                break;
-            }
-            case Operation::LSR:
-                [[fallthrough]]
-            case Operation::ROR: {
-                bool oldC = FlagC;
-                bool bit7 = (oldC && (op == Operation::ROR));
-                if (mode == AddressingMode::Accumulator) {
-                    FlagC = (mRegA & 1) != 0;
-                    mRegA >>= 1;
-                    // If Rotating, set the bit-0 to the the previous carry
-                    mRegA = mRegA | bit7 << 7;
-                    setZN(mRegA);
-                } else {
-                    ExtendedByte operand = mMainBus->read(location);
-                    FlagC = (operand & 1) != 0;
-                    operand = operand >> 1 | bit7 << 7;
-                    setZN(static_cast<Byte>(operand));
-                    mMainBus->write(location, static_cast<Byte>(operand));
+    namespace {
+#define ANNESE_OPCODE_VALUE(opcode) opcode,
+        constexpr const int OpcodesOrder[] = {ANNESE_OPCODES(ANNESE_OPCODE_VALUE)};
+#undef ANNESE_OPCODE_VALUE
+
+        constexpr bool OpcodesInOrder() {
+            for (int i = 0; i < 0x100; ++i) {
+                if (OpcodesOrder[i] != i) {
+                    return false;
                 }
-                break;
-            }
-            case Operation::STX:
-                mMainBus->write(location, mRegX);
-                break;
-            case Operation::LDX:
-                mRegX = mMainBus->read(location);
-                setZN(mRegX);
-                break;
-            case Operation::DEC: {
-                Byte value = mMainBus->read(location) - 1_b;
-                setZN(value);
-                mMainBus->write(location, value);
-                break;
-            }
-            case Operation::INC: {
-                Byte value = mMainBus->read(location) + 1_b;
-                setZN(value);
-                mMainBus->write(location, value);
-                break;
-            }
-            case Operation::BIT: {
-                ExtendedByte operand = mMainBus->read(location);
-                FlagZ = !(mRegA & operand);
-                FlagV = (operand & 0x40) != 0;
-                FlagN = (operand & 0x80) != 0;
-                break;
-            }
-            case Operation::STY:
-                mMainBus->write(location, mRegY);
-                break;
-            case Operation::LDY:
-                mRegY = mMainBus->read(location);
-                setZN(mRegY);
-                break;
-            case Operation::CPY: {
-                ExtendedByte diff = mRegY - mMainBus->read(location);
-                FlagC = !(diff & 0x100);
-                setZN(static_cast<Byte>(diff));
-                break;
-            }
-            case Operation::CPX: {
-                ExtendedByte diff = mRegX - mMainBus->read(location);
-                FlagC = !(diff & 0x100);
-                setZN(static_cast<Byte>(diff));
-                break;
             }
-            default:
-                assert(false);
+            return true;
         }
+
+        static_assert(sizeof(OpcodesOrder) / sizeof(OpcodesOrder[0]) == 0x100 && OpcodesInOrder(),
+                      "ANNESE_OPCODES must list every opcode in ascending order");
     }
 
-    std::tuple<Operation, AddressingMode, CycleLength> OpcodeDecoder::Decode(const Byte opcode) {
-        // Implied operation
-        CycleLength cycleLength = OperationCyclesAmount_[opcode];
-        using AMode = AddressingMode;
-        using Op = Operation;
-        using OpIm = OperationImplied_;
-        switch (static_cast<OpIm>(opcode)) {
-            case OpIm::NOP:  return {Op::NOP,  AMode::None, cycleLength};
-            case OpIm::BRK:  return {Op::BRK,  AMode::None, cycleLength};
-            case OpIm::JSR:  return {Op::JSR,  AMode::None, cycleLength};
-            case OpIm::RTI:  return {Op::RTI,  AMode::None, cycleLength};
-            case OpIm::RTS:  return {Op::RTS,  AMode::None, cycleLength};
-            case OpIm::JMP:  return {Op::JMP,  AMode::None, cycleLength};
-            case OpIm::JMPI: return {Op::JMPI, AMode::None, cycleLength};
-            case OpIm::PHP:  return {Op::PHP,  AMode::None, cycleLength};
-            case OpIm::PLP:  return {Op::PLP,  AMode::None, cycleLength};
-            case OpIm::PHA:  return {Op::PHA,  AMode::None, cycleLength};
-            case OpIm::PLA:  return {Op::PLA,  AMode::None, cycleLength};
-            case OpIm::DEY:  return {Op::DEY,  AMode::None, cycleLength};
-            case OpIm::DEX:  return {Op::DEX,  AMode::None, cycleLength};
-            case OpIm::TAY:  return {Op::TAY,  AMode::None, cycleLength};
-            case OpIm::INY:  return {Op::INY,  AMode::None, cycleLength};
-            case OpIm::INX:  return {Op::INX,  AMode::None, cycleLength};
-            case OpIm::CLC:  return {Op::CLC,  AMode::None, cycleLength};
-            case OpIm::SEC:  return {Op::SEC,  AMode::None, cycleLength};
-            case OpIm::CLI:  return {Op::CLI,  AMode::None, cycleLength};
-            case OpIm::SEI:  return {Op::SEI,  AMode::None, cycleLength};
-            case OpIm::TYA:  return {Op::TYA,  AMode::None, cycleLength};
-            case OpIm::CLV:  return {Op::CLV,  AMode::None, cycleLength};
-            case OpIm::CLD:  return {Op::CLD,  AMode::None, cycleLength};
-            case OpIm::SED:  return {Op::SED,  AMode::None, cycleLength};
-            case OpIm::TXA:  return {Op::TXA,  AMode::None, cycleLength};
-            case OpIm::TXS:  return {Op::TXS,  AMode::None, cycleLength};
-            case OpIm::TAX:  return {Op::TAX,  AMode::None, cycleLength};
-            case OpIm::TSX:  return {Op::TSX,  AMode::None, cycleLength};
-        }
+    template<bool InRAM, std::size_t... Opcodes>
+    constexpr std::array<CPU::Handler, 0x100> CPU::MakeHandlers(std::index_sequence<Opcodes...>) {
+        return {{&CPU::execute<OpcodeTable[Opcodes].operation, OpcodeTable[Opcodes].mode,
+                               InRAM && IsAbsolute(OpcodeTable[Opcodes].mode)>...}};
+    }
 
-        if ((opcode & BranchInstructionMask) == BranchInstructionMaskResult) {
-            bool condition = (opcode & (1 << BranchConditionBit)) != 0;
-            switch(static_cast<BranchOnFlag_>(opcode >> BranchOnFlagShift)) {
-                case BranchOnFlag_::Negative:
-                    return {condition ? Op::BMI : Op::BPL, AMode::Relative, cycleLength};
-                case BranchOnFlag_::Overflow:
-                    return {condition ? Op::BVS : Op::BVC, AMode::Relative, cycleLength};
-                case BranchOnFlag_::Carry:
-                    return {condition ? Op::BCS : Op::BCC, AMode::Relative, cycleLength};
-                case BranchOnFlag_::Zero:
-                    return {condition ? Op::BEQ : Op::BNE, AMode::Relative, cycleLength};
-            }
+    const std::array<CPU::Handler, 0x100> CPU::Handlers =
+            CPU::MakeHandlers<false>(std::make_index_sequence<0x100>());
+
+    const std::array<CPU::Handler, 0x100> CPU::RAMHandlers =
+            CPU::MakeHandlers<true>(std::make_index_sequence<0x100>());
+
+    template<Byte Length>
+    Address CPU::fetchOperand() {
+        if constexpr (Length == 1) {
+            return 0;
+        } else if constexpr (Length == 2) {
+            return mMainBus->read(mRegs.PC++);
+        } else {
+            Address operand = readAddress(mRegs.PC);
+            mRegs.PC += 2;
+            return operand;
         }
+    }
 
-        if ((opcode & InstructionModeMask) == 0x1) {
-            AddressingMode addressingMode;
-            switch(static_cast<AddressingMode1_>((opcode & AddressingModeMask) >> AddressingModeShift)) {
-                case AddressingMode1_::IndexedIndirectX: addressingMode = AMode::IndexedIndirectX; break;
-                case AddressingMode1_::ZeroPage: addressingMode = AMode::ZeroPage; break;
-                case AddressingMode1_::Immediate: addressingMode = AMode::Immediate; break;
-                case AddressingMode1_::Absolute: addressingMode = AMode::Absolute; break;
-                case AddressingMode1_::IndirectY: addressingMode = AMode::IndirectY; break;
-                case AddressingMode1_::IndexedX: addressingMode = AMode::IndexedX; break;
-                case AddressingMode1_::AbsoluteY: addressingMode = AMode::AbsoluteY; break;
-                case AddressingMode1_::AbsoluteX: addressingMode = AMode::AbsoluteX; break;
+    void CPU::execute(Byte opcode, CycleCount cycle) {
+        //Every opcode has its own handler specialized for its operation and addressing mode. Each handler counts
+        //its cycles and dispatches the next opcode itself
+#define ANNESE_OPCODE_EXECUTE(opcode) \
+        execute<OpcodeTable[opcode].operation, OpcodeTable[opcode].mode>(fetchOperand<OpcodeTable[opcode].length>()); \
+        mCycles += OpcodeTable[opcode].cycles
+#define ANNESE_OPCODE_DONE (mCycles >= cycle || mPendingNMI || mHalted)
+#if ANNESE_COMPUTED_GOTO
+#define ANNESE_OPCODE_LABEL(opcode) &&op_##opcode,
+#define ANNESE_OPCODE_HANDLER(opcode) \
+        op_##opcode: \
+        ANNESE_OPCODE_EXECUTE(opcode); \
+        if (ANNESE_OPCODE_DONE) { \
+            return; \
+        } \
+        goto *Labels[mMainBus->read(mRegs.PC++)];
+        static void *const Labels[] = {ANNESE_OPCODES(ANNESE_OPCODE_LABEL)};
+        goto *Labels[opcode];
+        ANNESE_OPCODES(ANNESE_OPCODE_HANDLER)
+#undef ANNESE_OPCODE_LABEL
+#else
+#define ANNESE_OPCODE_HANDLER(opcode) case opcode: ANNESE_OPCODE_EXECUTE(opcode); break;
+        while (true) {
+            switch (opcode) {
+                ANNESE_OPCODES(ANNESE_OPCODE_HANDLER)
             }
-            switch(static_cast<Operation1_>((opcode & OperationMask) >> OperationShift)) {
-                case Operation1_::ORA: return {Op::ORA, addressingMode, cycleLength};
-                case Operation1_::AND: return {Op::AND, addressingMode, cycleLength};
-                case Operation1_::EOR: return {Op::EOR, addressingMode, cycleLength};
-                case Operation1_::ADC: return {Op::ADC, addressingMode, cycleLength};
-                case Operation1_::STA: return {Op::STA, addressingMode, cycleLength};
-                case Operation1_::LDA: return {Op::LDA, addressingMode, cycleLength};
-                case Operation1_::CMP: return {Op::CMP, addressingMode, cycleLength};
-                case Operation1_::SBC: return {Op::SBC, addressingMode, cycleLength};
+            if (ANNESE_OPCODE_DONE) {
+                return;
             }
+            opcode = mMainBus->read(mRegs.PC++);
         }
+#endif
+#undef ANNESE_OPCODE_HANDLER
+#undef ANNESE_OPCODE_DONE
+#undef ANNESE_OPCODE_EXECUTE
+    }
 
-        if ((opcode & InstructionModeMask) == 0x2) {
-            AddressingMode addressingMode;
-            switch(static_cast<AddressingMode2_>((opcode & AddressingModeMask) >> AddressingModeShift)) {
-                case AddressingMode2_::Immediate: addressingMode = AMode::Immediate; break;
-                case AddressingMode2_::ZeroPage: addressingMode = AMode::ZeroPage; break;
-                case AddressingMode2_::Accumulator: addressingMode = AMode::Accumulator; break;
-                case AddressingMode2_::Absolute: addressingMode = AMode::Absolute; break;
-                case AddressingMode2_::Indexed: addressingMode = AMode::Indexed; break;
-                case AddressingMode2_::AbsoluteIndexed: addressingMode = AMode::AbsoluteIndexed; break;
+    template<Operation Op, AddressingMode Mode>
+    Address CPU::effectiveAddress(Address operand) {
+        //STX and LDX index by Y in the modes that index by X for the rest of the operations
+        constexpr bool IndexByY = Op == Operation::LDX || Op == Operation::STX;
+        constexpr CycleLength Penalty = PageCrossPenalty(Op, Mode);
+
+        if constexpr (Mode == AddressingMode::IndexedIndirectX) {
+            Byte zeroAddr = mRegs.X + operand;
+            return mRAM[zeroAddr] | mRAM[(zeroAddr + 1_a) & 0xff_a] << 8;
+        } else if constexpr (Mode == AddressingMode::ZeroPage || Mode == AddressingMode::Absolute) {
+            return operand;
+        } else if constexpr (Mode == AddressingMode::Immediate) {
+            //The operand byte itself, which precedes the next instruction
+            return mRegs.PC - 1_a;
+        } else if constexpr (Mode == AddressingMode::IndirectY) {
+            Address location = mRAM[operand] | mRAM[(operand + 1_a) & 0xff_a] << 8;
+            if constexpr (Penalty != 0) {
+                setPageCrossed(location, location + mRegs.Y, Penalty);
             }
-            switch(static_cast<Operation2_>((opcode & OperationMask) >> OperationShift)) {
-                case Operation2_::ASL: return {Op::ASL, addressingMode, cycleLength};
-                case Operation2_::ROL: return {Op::ROL, addressingMode, cycleLength};
-                case Operation2_::LSR: return {Op::LSR, addressingMode, cycleLength};
-                case Operation2_::ROR: return {Op::ROR, addressingMode, cycleLength};
-                case Operation2_::STX: return {Op::STX, addressingMode, cycleLength};
-                case Operation2_::LDX: return {Op::LDX, addressingMode, cycleLength};
-                case Operation2_::DEC: return {Op::DEC, addressingMode, cycleLength};
-                case Operation2_::INC: return {Op::INC, addressingMode, cycleLength};
+            return location + mRegs.Y;
+        } else if constexpr (Mode == AddressingMode::IndexedX) {
+            return (operand + mRegs.X) & 0xff_a;
+        } else if constexpr (Mode == AddressingMode::AbsoluteY || Mode == AddressingMode::AbsoluteX ||
+                             Mode == AddressingMode::AbsoluteIndexed) {
+            constexpr bool ByY = Mode == AddressingMode::AbsoluteY ||
+                                 (Mode == AddressingMode::AbsoluteIndexed && IndexByY);
+            Byte index = ByY ? mRegs.Y : mRegs.X;
+            if constexpr (Penalty != 0) {
+                setPageCrossed(operand, operand + index, Penalty);
             }
+            return operand + index;
+        } else if constexpr (Mode == AddressingMode::Indexed) {
+            Byte index = IndexByY ? mRegs.Y : mRegs.X;
+            return (operand + index) & 0xff_a;
+        } else {
+            static_assert(Mode == AddressingMode::Accumulator, "The addressing mode has no effective address");
+            return 0;
+        }
+    }
+
+    template<Operation Op, AddressingMode Mode, bool InRAM>
+    Byte CPU::load(Address operand) {
+        if constexpr (Mode == AddressingMode::Immediate) {
+            return static_cast<Byte>(operand);
+        } else {
+            return readMemory<InRAM>(effectiveAddress<Op, Mode>(operand));
         }
+    }
 
-        if ((opcode & InstructionModeMask) == 0x0) {
-            AddressingMode addressingMode;
-            switch(static_cast<AddressingMode2_>((opcode & AddressingModeMask) >> AddressingModeShift)) {
-                case AddressingMode2_::Immediate: addressingMode = AMode::Immediate; break;
-                case AddressingMode2_::ZeroPage: addressingMode = AMode::ZeroPage; break;
-                case AddressingMode2_::Accumulator: addressingMode = AMode::Accumulator; break;
-                case AddressingMode2_::Absolute: addressingMode = AMode::Absolute; break;
-                case AddressingMode2_::Indexed: addressingMode = AMode::Indexed; break;
-                case AddressingMode2_::AbsoluteIndexed: addressingMode = AMode::AbsoluteIndexed; break;
+    template<Operation Op, AddressingMode Mode, bool InRAM>
+    void CPU::execute(Address operand) {
+        using O = Operation;
+        //The zero page modes never leave the internal RAM
+        constexpr bool Direct = InRAM || Mode == AddressingMode::ZeroPage || Mode == AddressingMode::IndexedX ||
+                                Mode == AddressingMode::Indexed;
+        if constexpr (Op == O::ORA) {
+            mRegs.A |= load<Op, Mode, Direct>(operand);
+            setZN(mRegs.A);
+        } else if constexpr (Op == O::AND) {
+            mRegs.A &= load<Op, Mode, Direct>(operand);
+            setZN(mRegs.A);
+        } else if constexpr (Op == O::EOR) {
+            mRegs.A ^= load<Op, Mode, Direct>(operand);
+            setZN(mRegs.A);
+        } else if constexpr (Op == O::ADC) {
+            Byte value = load<Op, Mode, Direct>(operand);
+            ExtendedByte sum = mRegs.A + value + mRegs.carry;
+            // Unsigned overflow
+            mRegs.carry = static_cast<Byte>(sum >> 8);
+            // Signed overflow, would only happen if the sign of sum is
+            // different from both the operands
+            mRegs.overflow = static_cast<Byte>((mRegs.A ^ sum) & (value ^ sum));
+            mRegs.A = static_cast<Byte>(sum);
+            setZN(mRegs.A);
+        } else if constexpr (Op == O::STA) {
+            writeMemory<Direct>(effectiveAddress<Op, Mode>(operand), mRegs.A);
+        } else if constexpr (Op == O::LDA) {
+            mRegs.A = load<Op, Mode, Direct>(operand);
+            setZN(mRegs.A);
+        } else if constexpr (Op == O::CMP) {
+            ExtendedByte diff = mRegs.A - load<Op, Mode, Direct>(operand);
+            mRegs.carry = !(diff & 0x100);
+            setZN(static_cast<Byte>(diff));
+        } else if constexpr (Op == O::SBC) {
+            ExtendedByte subtrahend = load<Op, Mode, Direct>(operand);
+            //High carry means "no borrow", thus negate and subtract
+            ExtendedByte diff = mRegs.A - subtrahend - !mRegs.carry;
+            // If the ninth bit is 1, the resulting number is negative => borrow => low carry
+            mRegs.carry = !(diff & 0x100);
+            // Same as ADC, except instead of the subtrahend,
+            // substitute with it's one complement
+            mRegs.overflow = static_cast<Byte>((mRegs.A ^ diff) & (~subtrahend ^ diff));
+            mRegs.A = static_cast<Byte>(diff);
+            setZN(static_cast<Byte>(diff));
+        } else if constexpr (Op == O::ASL || Op == O::ROL) {
+            // If Rotating, set the bit-0 to the the previous carry
+            bool bit0 = Op == O::ROL && mRegs.carry;
+            if constexpr (Mode == AddressingMode::Accumulator) {
+                mRegs.carry = mRegs.A >> 7;
+                mRegs.A = mRegs.A << 1 | bit0;
+                setZN(mRegs.A);
+            } else {
+                Address location = effectiveAddress<Op, Mode>(operand);
+                ExtendedByte value = readMemory<Direct>(location);
+                mRegs.carry = static_cast<Byte>(value >> 7);
+                value = value << 1 | bit0;
+                setZN(static_cast<Byte>(value));
+                writeMemory<Direct>(location, static_cast<Byte>(value));
+            }
+        } else if constexpr (Op == O::LSR || Op == O::ROR) {
+            // If Rotating, set the bit-7 to the the previous carry
+            bool bit7 = Op == O::ROR && mRegs.carry;
+            if constexpr (Mode == AddressingMode::Accumulator) {
+                mRegs.carry = mRegs.A & 1_b;
+                mRegs.A = mRegs.A >> 1 | bit7 << 7;
+                setZN(mRegs.A);
+            } else {
+                Address location = effectiveAddress<Op, Mode>(operand);
+                ExtendedByte value = readMemory<Direct>(location);
+                mRegs.carry = static_cast<Byte>(value & 1);
+                value = value >> 1 | bit7 << 7;
+                setZN(static_cast<Byte>(value));
+                writeMemory<Direct>(location, static_cast<Byte>(value));
+            }
+        } else if constexpr (Op == O::STX) {
+            writeMemory<Direct>(effectiveAddress<Op, Mode>(operand), mRegs.X);
+        } else if constexpr (Op == O::LDX) {
+            mRegs.X = load<Op, Mode, Direct>(operand);
+            setZN(mRegs.X);
+        } else if constexpr (Op == O::DEC || Op == O::INC) {
+            Address location = effectiveAddress<Op, Mode>(operand);
+            Byte value = readMemory<Direct>(location) + (Op == O::INC ? 1_b : 0xff_b);
+            setZN(value);
+            writeMemory<Direct>(location, value);
+        } else if constexpr (Op == O::BIT) {
+            Byte value = load<Op, Mode, Direct>(operand);
+            mRegs.zero = mRegs.A & value;
+            mRegs.overflow = value << 1;
+            mRegs.negative = value;
+        } else if constexpr (Op == O::STY) {
+            writeMemory<Direct>(effectiveAddress<Op, Mode>(operand), mRegs.Y);
+        } else if constexpr (Op == O::LDY) {
+            mRegs.Y = load<Op, Mode, Direct>(operand);
+            setZN(mRegs.Y);
+        } else if constexpr (Op == O::CPY) {
+            ExtendedByte diff = mRegs.Y - load<Op, Mode, Direct>(operand);
+            mRegs.carry = !(diff & 0x100);
+            setZN(static_cast<Byte>(diff));
+        } else if constexpr (Op == O::CPX) {
+            ExtendedByte diff = mRegs.X - load<Op, Mode, Direct>(operand);
+            mRegs.carry = !(diff & 0x100);
+            setZN(static_cast<Byte>(diff));
+        } else if constexpr (Op == O::NOP) {
+        } else if constexpr (Op == O::BRK) {
+            interrupt(Interruption::BRK);
+        } else if constexpr (Op == O::JSR) {
+            //The return address is the last byte of the JSR
+            pushToStack(static_cast<Byte>((mRegs.PC - 1) >> 8));
+            pushToStack(static_cast<Byte>((mRegs.PC - 1)));
+            mRegs.PC = operand;
+        } else if constexpr (Op == O::RTI) {
+            setStatus(pullFromStack());
+            mRegs.PC = pullFromStack();
+            mRegs.PC |= pullFromStack() << 8;
+        } else if constexpr (Op == O::RTS) {
+            mRegs.PC = pullFromStack();
+            mRegs.PC |= pullFromStack() << 8;
+            ++mRegs.PC;
+        } else if constexpr (Op == O::JMP) {
+            mRegs.PC = operand;
+        } else if constexpr (Op == O::JMPI) {
+            Address location = operand;
+            //6502 has a bug such that the when the vector of an indirect address begins at the last byte of a page,
+            //the second byte is fetched from the beginning of that page rather than the beginning of the next
+            //Recreating here:
+            Address page = location & 0xff00_a;
+            mRegs.PC = mMainBus->read(location) |
+                     mMainBus->read(page | ((location + 1_a) & 0xff_a)) << 8;
+        } else if constexpr (Op == O::PHP) {
+            mRegs.status |= FlagB;
+            pushToStack(status());
+        } else if constexpr (Op == O::PLP) {
+            setStatus(pullFromStack());
+        } else if constexpr (Op == O::PHA) {
+            pushToStack(mRegs.A);
+        } else if constexpr (Op == O::PLA) {
+            mRegs.A = pullFromStack();
+            setZN(mRegs.A);
+        } else if constexpr (Op == O::DEY) {
+            --mRegs.Y;
+            setZN(mRegs.Y);
+        } else if constexpr (Op == O::DEX) {
+            --mRegs.X;
+            setZN(mRegs.X);
+        } else if constexpr (Op == O::TAY) {
+            mRegs.Y = mRegs.A;
+            setZN(mRegs.Y);
+        } else if constexpr (Op == O::INY) {
+            ++mRegs.Y;
+            setZN(mRegs.Y);
+        } else if constexpr (Op == O::INX) {
+            ++mRegs.X;
+            setZN(mRegs.X);
+        } else if constexpr (Op == O::CLC) {
+            mRegs.carry = 0;
+        } else if constexpr (Op == O::SEC) {
+            mRegs.carry = 1;
+        } else if constexpr (Op == O::CLI) {
+            mRegs.status &= ~FlagI;
+        } else if constexpr (Op == O::SEI) {
+            mRegs.status |= FlagI;
+        } else if constexpr (Op == O::CLD) {
+            mRegs.status &= ~FlagD;
+        } else if constexpr (Op == O::SED) {
+            mRegs.status |= FlagD;
+        } else if constexpr (Op == O::TYA) {
+            mRegs.A = mRegs.Y;
+            setZN(mRegs.A);
+        } else if constexpr (Op == O::CLV) {
+            mRegs.overflow = 0;
+        } else if constexpr (Op == O::TXA) {
+            mRegs.A = mRegs.X;
+            setZN(mRegs.A);
+        } else if constexpr (Op == O::TXS) {
+            mRegs.SP = mRegs.X;
+        } else if constexpr (Op == O::TAX) {
+            mRegs.X = mRegs.A;
+            setZN(mRegs.X);
+        } else if constexpr (Op == O::TSX) {
+            mRegs.X = mRegs.SP;
+            setZN(mRegs.X);
+        } else {
+            static_assert(Mode == AddressingMode::Relative, "Unhandled operation");
+            bool branch;
+            if constexpr (Op == O::BCC) {
+                branch = !mRegs.carry;
+            } else if constexpr (Op == O::BCS) {
+                branch = mRegs.carry;
+            } else if constexpr (Op == O::BNE) {
+                branch = mRegs.zero;
+            } else if constexpr (Op == O::BEQ) {
+                branch = !mRegs.zero;
+            } else if constexpr (Op == O::BPL) {
+                branch = !(mRegs.negative & 0x80);
+            } else if constexpr (Op == O::BMI) {
+                branch = mRegs.negative & 0x80;
+            } else if constexpr (Op == O::BVC) {
+                branch = !(mRegs.overflow & 0x80);
+            } else {
+                static_assert(Op == O::BVS, "Unhandled branch");
+                branch = mRegs.overflow & 0x80;
             }
-            switch(static_cast<Operation0_>((opcode & OperationMask) >> OperationShift)) {
-                case Operation0_::BIT: return {Op::BIT, addressingMode, cycleLength};
-                case Operation0_::STY: return {Op::STY, addressingMode, cycleLength};
-                case Operation0_::LDY: return {Op::LDY, addressingMode, cycleLength};
-                case Operation0_::CPY: return {Op::CPY, addressingMode, cycleLength};
-                case Operation0_::CPX: return {Op::CPX, addressingMode, cycleLength};
+            if (branch) {
+                ++mCycles;
+                Address newPC = mRegs.PC + static_cast<SByte>(operand);
+                setPageCrossed(mRegs.PC, newPC, 2);
+                mRegs.PC = newPC;
             }
         }
-        assert(false);
     }
 }
-#pragma clang diagnostic pop
\ No newline at end of file
+#pragma clang diagnostic pop
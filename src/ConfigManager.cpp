@@ -1,4 +1,6 @@
 #define CPPTOML_USE_MAP
+#include <cstdint>
+#include <limits>
 #include <cpptoml.h>
 #include "../include/ConfigManager.h"
 #include "../include/TeeLog.hpp"
@@ -112,6 +114,8 @@ namespace ANNESE {
     void ConfigManager::loadDefaults() {
         using Kb = sf::Keyboard;
         configuration.application.scale = 2.0f;
+        configuration.application.renderThread = false;
+        configuration.application.fastForward = 4;
         configuration.player1 = {Kb::T, Kb::Y, Kb::E, Kb::R, Kb::W, Kb::S, Kb::A, Kb::D};
         configuration.player2 = {Kb::LBracket, Kb::RBracket, Kb::O, Kb::P, Kb::I, Kb::K, Kb::J, Kb::L};
     }
@@ -133,6 +137,14 @@ namespace ANNESE {
                 return false;
             }
             configuration.application.scale = static_cast<float>(*opt);
+            //Added later, so the older files may miss it
+            configuration.application.renderThread = app->get_as<bool>("render_thread").value_or(false);
+            std::int64_t fastForward = app->get_as<int64_t>("fast_forward").value_or(4);
+            if (fastForward < 0 || fastForward > std::numeric_limits<unsigned>::max()) {
+                Log(Error) << "Invalid fast_forward " << fastForward << ", using 4" << std::endl;
+                fastForward = 4;
+            }
+            configuration.application.fastForward = static_cast<unsigned>(fastForward);
         }
 
         auto pConf = root->get_table("player 1");
@@ -168,6 +180,8 @@ namespace ANNESE {
 
         auto app = ::cpptoml::make_table();
         app->insert("scale", static_cast<double>(configuration.application.scale));
+        app->insert("render_thread", configuration.application.renderThread);
+        app->insert("fast_forward", static_cast<int64_t>(configuration.application.fastForward));
         root->insert("application", app);
 
         auto *player = &configuration.player1;
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include "../include/Console.h"
+#include "../include/Cartridge.h"
+#include "../include/CartridgeLoader.h"
+#include "../include/Mapper.h"
+#include "../include/MainBus.h"
+#include "../include/PictureBus.h"
+#include "../include/CPU.h"
+#include "../include/PPU.h"
+#include "../include/PPURenderer.h"
+#include "../include/Joypad.h"
+#include "../include/TeeLog.hpp"
+
+namespace ANNESE {
+    Console::Console(std::shared_ptr<VideoSink> video,
+                     std::shared_ptr<InputSource> player1, std::shared_ptr<InputSource> player2) {
+        mMainBus = std::make_shared<MainBus>();
+        mPictureBus = std::make_shared<PictureBus>();
+        mPPU = std::make_shared<PPU>(mPictureBus, std::move(video));
+        mCPU = std::make_shared<CPU>(mMainBus);
+        mJoypad1 = std::make_shared<Joypad>(std::move(player1));
+        mJoypad2 = std::make_shared<Joypad>(std::move(player2));
+
+        (*mMainBus.get())
+                .setReadCallback<PPU, &PPU::status>(IORegisters::PPUStatus, mPPU.get())
+                .setReadCallback<PPU, &PPU::data>(IORegisters::PPUData, mPPU.get())
+                .setReadCallback<PPU, &PPU::OAMData>(IORegisters::OAMData, mPPU.get())
+                .setReadCallback<Joypad, &Joypad::read>(IORegisters::Joy1, mJoypad1.get())
+                .setReadCallback<Joypad, &Joypad::read>(IORegisters::Joy2, mJoypad2.get())
+                .setWriteCallback<PPU, &PPU::control>(IORegisters::PPUCtrl, mPPU.get())
+                .setWriteCallback<PPU, &PPU::mask>(IORegisters::PPUMask, mPPU.get())
+                .setWriteCallback<PPU, &PPU::OAMAddress>(IORegisters::OAMAddr, mPPU.get())
+                .setWriteCallback<PPU, &PPU::dataAddress>(IORegisters::PPUAddr, mPPU.get())
+                .setWriteCallback<PPU, &PPU::scroll>(IORegisters::PPUScroll, mPPU.get())
+                .setWriteCallback<PPU, &PPU::data>(IORegisters::PPUData, mPPU.get())
+                .setWriteCallback<PPU, &PPU::OAMData>(IORegisters::OAMData, mPPU.get())
+                .setWriteCallback<Console, &Console::doOAMDMA>(IORegisters::OAMDMA, this)
+                .setWriteCallback<Console, &Console::strobeJoypads>(IORegisters::Joy1, this);
+        mMainBus->setPPUSyncCallback([=]() {
+            syncPPU();
+        });
+        mCPU->setPPUStatusHorizonCallback([=]() {
+            //PPUSTATUS is polled, so the PPU has just been caught up and its state is recent enough
+            return ToCycle(mClock + mPPU->dotsUntilStatusChange());
+        });
+    }
+
+    bool Console::load(std::istream &rom) {
+        std::unique_ptr<Cartridge> cartridge = CartridgeLoader::Load(rom);
+        if (!cartridge) {
+            Log(Error) << "Failed to load the cartridge" << std::endl;
+            return false;
+        }
+        mMapper = Mapper::Create(std::move(cartridge), [&]() {
+                                     mPictureBus->updateMirroring();
+                                 });
+        mMainBus->setMapper(mMapper);
+        mPictureBus->setCHRMemory(mMapper);
+        if (mRenderThread) {
+            mPPU->setRenderer(std::make_shared<PPURenderer>(mMapper->hasCHRRAM()));
+        }
+        mCPU->reset();
+        mPPU->reset();
+        mClock = mCPU->cycles() * DotsPerCycle;
+        mEvents.clear();
+        mDMALength = 0;
+        mEvents.schedule(EventQueue::Event::VBlank, mClock + mPPU->dotsUntilVBlank());
+        return true;
+    }
+
+    void Console::setProfiler(std::shared_ptr<Profiler> profiler) {
+        mCPU->setProfiler(std::move(profiler));
+    }
+
+    CycleCount Console::cycles() const {
+        return mCPU->cycles();
+    }
+
+    void Console::emulateUntil(CycleCount cycle) {
+        while (mCPU->cycles() < cycle) {
+            //Stop at the next event so that it is handled in time. Never is left alone, rounding it up overflows
+            CycleCount next = mEvents.next();
+            mCPU->runUntil(next == EventQueue::Never ? cycle : std::min(cycle, ToCycle(next)));
+            if (mDMALength) {
+                //The DMA takes the bus once the instruction that started it is done. The write to OAMDMA is the
+                //last cycle of that instruction, and one more cycle is taken if it is an odd one
+                CycleCount write = mCPU->cycles() - 1;
+                mEvents.schedule(EventQueue::Event::DMA, (mCPU->cycles() + mDMALength + (write & 1)) * DotsPerCycle);
+                mDMALength = 0;
+            }
+            syncPPU();
+            dispatchEvents();
+        }
+    }
+
+    void Console::runFrame() {
+        std::uint64_t frame = mPPU->frameCount();
+        while (mPPU->frameCount() == frame) {
+            emulateUntil(ToCycle(mClock + mPPU->dotsUntilVBlank()));
+        }
+    }
+
+    void Console::syncPPU() {
+        for (CycleCount dot = mCPU->cycles() * DotsPerCycle; mClock < dot; mClock += DotsPerCycle) {
+            mPPU->step();
+            mPPU->step();
+            mPPU->step();
+        }
+        mPPU->flush();
+    }
+
+    void Console::dispatchEvents() {
+        EventQueue::Event event;
+        while (mEvents.pop(mClock, event)) {
+            switch (event) {
+                case EventQueue::Event::VBlank:
+                    if (mPPU->takeNMI()) {
+                        mCPU->requestNMI();
+                    }
+                    //Either the next frame or this one again, if the lower bound was short
+                    mEvents.schedule(EventQueue::Event::VBlank, mClock + mPPU->dotsUntilVBlank());
+                    break;
+                case EventQueue::Event::DMA:
+                    mCPU->resume();
+                    break;
+                case EventQueue::Event::Count:
+                    break;
+            }
+        }
+    }
+
+    void Console::doOAMDMA(Byte page) {
+        mPPU->doDMA(mMainBus->getPagePtr(page));
+        //256 reads, 256 writes and a dummy read. The cycle of this write is only known once the instruction is done,
+        //emulateUntil adds the alignment cycle then
+        mDMALength = 513;
+        mCPU->halt();
+    }
+
+    void Console::strobeJoypads(Byte value) {
+        mJoypad1->strobe(value);
+        mJoypad2->strobe(value);
+    }
+}
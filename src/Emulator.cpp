@@ -1,97 +1,34 @@
+#include <atomic>
+#include <thread>
 #include <SFML/Window/Event.hpp>
 #include "../include/Emulator.h"
-#include "../include/Cartridge.h"
-#include "../include/CartridgeLoader.h"
-#include "../include/Mapper.h"
-#include "../include/MainBus.h"
-#include "../include/CPU.h"
+#include "../include/Console.h"
 #include "../include/PPU.h"
+#include "../include/Screen.h"
+#include "../include/KeyboardInput.h"
+#include "../include/FramePacer.h"
 #include "../include/TeeLog.hpp"
-#include "../include/Joypad.h"
 
 namespace ANNESE {
     Emulator::Emulator(const Configuration &conf)
             : mWindow(sf::VideoMode(static_cast<unsigned int>(PPU::ScanlineVisibleDots * conf.application.scale),
                                     static_cast<unsigned int>(PPU::VisibleScanlines * conf.application.scale)),
-                      "ANNESE", sf::Style::Titlebar | sf::Style::Close) {
-        mMainBus = std::make_shared<MainBus>();
-        mPictureBus = std::make_shared<PictureBus>();
+                      "ANNESE", sf::Style::Titlebar | sf::Style::Close),
+              mFastForwardFactor(conf.application.fastForward) {
         mScreen = std::make_shared<Screen>(sf::Vector2i{PPU::ScanlineVisibleDots,
                                                         PPU::VisibleScanlines},
                                            conf.application.scale);
-        mPPU = std::make_shared<PPU>(mPictureBus, mScreen);
-        mCPU = std::make_shared<CPU>(mMainBus);
-        mJoypad1 = std::make_shared<Joypad>(conf.player1);
-        mJoypad2 = std::make_shared<Joypad>(conf.player2);
-
-        (*mMainBus.get())
-                .setReadCallback(IORegisters::PPUStatus, [=]() {
-                    return mPPU->status();
-                })
-                .setReadCallback(IORegisters::PPUData, [=]() {
-                    return mPPU->data();
-                })
-                .setReadCallback(IORegisters::OAMData, [=]() {
-                    return mPPU->OAMData();
-                })
-                .setReadCallback(IORegisters::Joy1, [=]() {
-                    return mJoypad1->read();
-                })
-                .setReadCallback(IORegisters::Joy2, [=]() {
-                    return mJoypad2->read();
-                })
-                .setWriteCallback(IORegisters::PPUCtrl, [=](Byte value) {
-                    mPPU->control(value);
-                })
-                .setWriteCallback(IORegisters::PPUMask, [=](Byte value) {
-                    mPPU->mask(value);
-                })
-                .setWriteCallback(IORegisters::OAMAddr, [=](Byte value) {
-                    mPPU->OAMAddress(value);
-                })
-                .setWriteCallback(IORegisters::PPUAddr, [=](Byte value) {
-                    mPPU->dataAddress(value);
-                })
-                .setWriteCallback(IORegisters::PPUScroll, [=](Byte value) {
-                    mPPU->scroll(value);
-                })
-                .setWriteCallback(IORegisters::PPUData, [=](Byte value) {
-                    mPPU->data(value);
-                })
-                .setWriteCallback(IORegisters::OAMData, [=](Byte value) {
-                    mPPU->OAMData(value);
-                })
-                .setWriteCallback(IORegisters::OAMDMA, [=](Byte value) {
-                    mCPU->skipDMACycles();
-                    mPPU->doDMA(mMainBus->getPagePtr(value));
-                })
-                .setWriteCallback(IORegisters::Joy1, [=](Byte value) {
-                    mJoypad1->strobe(value);
-                    mJoypad2->strobe(value);
-                });
-//                .setWriteCallback(IORegisters::Joy2, [=](Byte value) {
-//                    mJoypad1->strobe(value);
-//                    mJoypad2->strobe(value);
-//                });
-    mPPU->setInterruptCallback([=]() {
-        mCPU->interrupt(CPU::Interruption::NMI);
-    });
+        mKeyboard1 = std::make_shared<KeyboardInput>(conf.player1);
+        mKeyboard2 = std::make_shared<KeyboardInput>(conf.player2);
+        mConsole = std::make_shared<Console>(mScreen, mKeyboard1, mKeyboard2);
+        mConsole->setRenderThread(conf.application.renderThread);
         mWindow.setVerticalSyncEnabled(true);
     }
 
     void ANNESE::Emulator::run(std::istream &rom) {
-        std::unique_ptr<Cartridge> cartridge = CartridgeLoader::Load(rom);
-        if (!cartridge) {
-            Log(Error) << "Failed to load the cartridge" << std::endl;
+        if (!mConsole->load(rom)) {
             exit(1);
         }
-        mMapper = Mapper::Create(std::move(cartridge), [&]() {
-                                     mPictureBus->updateMirroring();
-                                 });
-        mMainBus->setMapper(mMapper);
-        mPictureBus->setMapper(mMapper);
-        mCPU->reset();
-        mPPU->reset();
 
         sf::Event event{};
         bool keep = true;
@@ -125,8 +62,11 @@ namespace ANNESE {
             mWindow.display();
         }
 
-        elapsed = std::chrono::high_resolution_clock::duration(0);
-        timer = std::chrono::high_resolution_clock::now();
+        //The window only shows the newest picture and samples the keys, so it never holds the emulation back
+        std::atomic<bool> emulating{true};
+        std::thread emulation([this, &emulating]() {
+            emulate(emulating);
+        });
 
         while (mWindow.isOpen()) {
             while (mWindow.pollEvent(event)) {
@@ -140,24 +80,38 @@ namespace ANNESE {
             if (!keep) {
                 break;
             }
-            auto newTimer = std::chrono::high_resolution_clock::now();
-            elapsed += newTimer - timer;
-            timer = newTimer;
+            mKeyboard1->poll();
+            mKeyboard2->poll();
+            mFastForward = sf::Keyboard::isKeyPressed(FastForwardKey);
 
-            while (elapsed > CPUCycleDuration) {
-                mPPU->step();
-                mPPU->step();
-                mPPU->step();
+            mWindow.draw(*mScreen);
+            mWindow.display();
+        }
 
-                mCPU->step();
+        emulating = false;
+        emulation.join();
+    }
 
-                elapsed -= CPUCycleDuration;
+    void Emulator::emulate(const std::atomic<bool> &emulating) {
+        FramePacer pacer;
+        pacer.setFastForwardFactor(mFastForwardFactor);
+        while (emulating.load(std::memory_order_relaxed)) {
+            if (!mFastForward.load(std::memory_order_relaxed)) {
+                pacer.setMode(FramePacer::Mode::RealTime);
+            } else if (mFastForwardFactor) {
+                pacer.setMode(FramePacer::Mode::FastForward);
+            } else {
+                pacer.setMode(FramePacer::Mode::Unthrottled);
             }
-            mWindow.draw(*mScreen);
-            mWindow.display();
+            mConsole->runFrame();
+            pacer.wait();
         }
     }
 
+    void Emulator::setProfiler(std::shared_ptr<Profiler> profiler) {
+        mConsole->setProfiler(std::move(profiler));
+    }
+
     bool Emulator::initLogoText(sf::Text &acronym, sf::Text &fullName, sf::Font &font) const {
         if (!font.loadFromFile(FontName)) {
             Log(Error) << "Failed to load font for logo: " << FontName << std::endl;
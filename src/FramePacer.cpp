@@ -0,0 +1,48 @@
+#include <thread>
+#include "../include/FramePacer.h"
+
+namespace ANNESE {
+    FramePacer::FramePacer() {
+        restart();
+    }
+
+    void FramePacer::setMode(Mode mode) {
+        if (mode != mMode) {
+            mMode = mode;
+            restart();
+        }
+    }
+
+    void FramePacer::setFastForwardFactor(unsigned factor) {
+        mFastForwardFactor = factor ? factor : 1;
+        restart();
+    }
+
+    void FramePacer::wait() {
+        if (mMode == Mode::Unthrottled) {
+            return;
+        }
+        ++mFrames;
+        unsigned factor = mMode == Mode::FastForward ? mFastForwardFactor : 1;
+        Clock::time_point deadline = mStart + std::chrono::duration_cast<Clock::duration>(
+                FrameDuration * static_cast<std::int64_t>(mFrames)) / factor;
+
+        Clock::time_point now = Clock::now();
+        if (now > deadline + MaxLag) {
+            //Catching up would only make the host fall further behind
+            restart();
+            return;
+        }
+        if (deadline - now > SpinDuration) {
+            std::this_thread::sleep_until(deadline - SpinDuration);
+        }
+        while (Clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
+
+    void FramePacer::restart() {
+        mStart = Clock::now();
+        mFrames = 0;
+    }
+}
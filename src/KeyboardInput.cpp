@@ -0,0 +1,24 @@
+#include "../include/KeyboardInput.h"
+
+namespace ANNESE {
+    KeyboardInput::KeyboardInput(const Configuration::Joypad &conf) {
+        mKeyBindings.push_back(conf.a);
+        mKeyBindings.push_back(conf.b);
+        mKeyBindings.push_back(conf.select);
+        mKeyBindings.push_back(conf.start);
+        mKeyBindings.push_back(conf.up);
+        mKeyBindings.push_back(conf.down);
+        mKeyBindings.push_back(conf.left);
+        mKeyBindings.push_back(conf.right);
+    }
+
+    void KeyboardInput::poll() {
+        Byte buttons = 0;
+        int shift = 0;
+        for (auto key : mKeyBindings) {
+            buttons |= (sf::Keyboard::isKeyPressed(key) << shift);
+            ++shift;
+        }
+        mButtons.store(buttons, std::memory_order_relaxed);
+    }
+}
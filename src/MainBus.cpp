@@ -24,23 +24,32 @@
 namespace ANNESE {
     MainBus::MainBus()
             : mRAM(0x800, 0) {
+        mReadPages.fill(nullptr);
+        mWritePages.fill(nullptr);
+        //The 2KB of RAM are mirrored up to the PPU registers
+        for (int page = 0; page < static_cast<int>(MemoryMap::PPU) >> 8; ++page) {
+            mReadPages[page] = mWritePages[page] = &mRAM[(page & 0x7) << 8];
+        }
     }
 
-    Byte MainBus::read(Address addr) {
+    Byte MainBus::readIO(Address addr) {
         using Mem = MemoryMap;
         if (IN_RAM(addr)) {
             return mRAM.at(addr & 0x7ffu);   // User area varies from 0x200 to 0x7ff
         } else if (IN_PPU(addr)) {
-            auto it = mReadCallbacks.find(static_cast<IORegisters>(addr & 0x2007));
-            if (it != mReadCallbacks.end()) {
-                return it->second();
+            if (mPPUSyncCallback) {
+                mPPUSyncCallback();
+            }
+            const ReadHandler &handler = mReadHandlers[RegisterIndex(addr)];
+            if (handler.call) {
+                return handler.call(handler.object);
             } else {
                 Log(Debug) << "No read callback registered for I/O register at: " << +addr << std::endl;
             }
         } else if (IN_APU(addr)) {    // >0x4014
-            auto it = mReadCallbacks.find(static_cast<IORegisters>(addr));
-            if (it != mReadCallbacks.end()) {
-                return it->second();
+            const ReadHandler &handler = mReadHandlers[RegisterIndex(addr)];
+            if (handler.call) {
+                return handler.call(handler.object);
             } else {
                 static bool once = false;
                 if (!once) {
@@ -66,22 +75,28 @@ namespace ANNESE {
         return 0_b;
     }
 
-    void MainBus::write(Address addr, Byte value) {
+    void MainBus::writeIO(Address addr, Byte value) {
         using Mem = MemoryMap;
         if (IN_RAM(addr)) {
             mRAM.at(addr & 0x7ffu) = value;   // User area varies from 0x200 to 0x7ff
         } else if (IN_PPU(addr)) {
-            auto it = mWriteCallbacks.find(static_cast<IORegisters>(addr & 0x2007));
-            if (it != mWriteCallbacks.end()) {
-                it->second(value);
+            if (mPPUSyncCallback) {
+                mPPUSyncCallback();
+            }
+            const WriteHandler &handler = mWriteHandlers[RegisterIndex(addr)];
+            if (handler.call) {
+                handler.call(handler.object, value);
             } else {
                 Log(Debug) << "No write callback registered for I/O register at: "
                           << std::hex << addr << std::dec << std::endl;
             }
         } else if (IN_APU(addr)) {  // Unsupported. Maybe temporarily...
-            auto it = mWriteCallbacks.find(static_cast<IORegisters>(addr));
-            if (it != mWriteCallbacks.end()) {
-                it->second(value);
+            if (addr == static_cast<Address>(IORegisters::OAMDMA) && mPPUSyncCallback) {
+                mPPUSyncCallback();
+            }
+            const WriteHandler &handler = mWriteHandlers[RegisterIndex(addr)];
+            if (handler.call) {
+                handler.call(handler.object, value);
             } else {
                 static bool once = false;
                 if (!once) {
@@ -102,6 +117,10 @@ namespace ANNESE {
                 mExtRAM[addr - static_cast<Address>(Mem::SRAM)] = value;
             }
         } else {
+            //Mapper registers may switch CHR banks or mirroring
+            if (mPPUSyncCallback) {
+                mPPUSyncCallback();
+            }
             mMapper->writePRG(addr, value);
         }
     }
@@ -113,21 +132,29 @@ namespace ANNESE {
         mMapper = mapper;
         if (mMapper->hasExtendedRAM()) {
             mExtRAM.resize(0x2000);
+            for (int page = static_cast<int>(MemoryMap::SRAM) >> 8; page < static_cast<int>(MemoryMap::PRG) >> 8; ++page) {
+                mReadPages[page] = mWritePages[page] = &mExtRAM[(page << 8) - static_cast<int>(MemoryMap::SRAM)];
+            }
         }
+        mMapper->setPRGBankCallback([this]() {
+            updatePRGPages();
+        });
+        updatePRGPages();
         return true;
     }
 
+    void MainBus::updatePRGPages() {
+        //The writes go to the mapper registers
+        for (int page = static_cast<int>(MemoryMap::PRG) >> 8; page < 0x100; ++page) {
+            mReadPages[page] = mMapper->getPagePtr(static_cast<Address>(page << 8));
+        }
+    }
+
     const Byte *MainBus::getPagePtr(Byte page) {
-        using Mem = MemoryMap;
-        Address addr = page << 8;
-        if (IN_RAM(addr)) {
-            return &mRAM[addr & 0x7ff];
-        } else if (IN_SRAM(addr)) {
-            if (mMapper->hasExtendedRAM()) {
-                return &mExtRAM[addr - static_cast<Address>(Mem::SRAM)];
-            }
+        if (mReadPages[page]) {
+            return mReadPages[page];
         }
-        Log(Error) << "Attempt to access the page: " << page << std::endl;
+        Log(Error) << "Attempt to access the page: " << +page << std::endl;
         return nullptr;
     }
 }
\ No newline at end of file
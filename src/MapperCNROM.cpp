@@ -1,3 +1,4 @@
+#include <stdexcept>
 #include "../include/MapperCNROM.h"
 #include "../include/TeeLog.hpp"
 
@@ -5,11 +6,21 @@ namespace ANNESE {
 
     MapperCNROM::MapperCNROM(std::unique_ptr<Cartridge> &&cartridge)
             : Mapper(std::move(cartridge)) {
+        //The board switches CHR ROM banks, there is no CHR RAM to fall back on
+        if (mCartridge->VROM().size() < 0x2000) {
+            Log(Error) << "CNROM cartridge without CHR ROM" << std::endl;
+            throw std::invalid_argument("CNROM cartridge without CHR ROM");
+        }
         mOneBank = mCartridge->ROM().size() == 0x4000;
     }
 
     void MapperCNROM::writePRG(Address addr, Byte value) {
-        mSelectCHR = value & 0x3_a;
+        //The bits above the number of banks are not connected
+        Address bank = static_cast<Address>((value & 0x3_a) % (mCartridge->VROM().size() / 0x2000));
+        if (mSelectCHR != bank) {
+            mSelectCHR = bank;
+            switchedCHRBanks();
+        }
     }
 
     Byte MapperCNROM::readPRG(Address addr) const {
@@ -24,6 +35,10 @@ namespace ANNESE {
         return mCartridge->VROM().at(addr | mSelectCHR << 13);
     }
 
+    const Byte *MapperCNROM::getCHRPtr(Address addr) const {
+        return &mCartridge->VROM()[addr | mSelectCHR << 13];
+    }
+
     const Byte *MapperCNROM::getPagePtr(Address addr) const {
         if (!mOneBank) {
             return &mCartridge->ROM().at(addr - 0x8000_a);
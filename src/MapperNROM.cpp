@@ -40,5 +40,9 @@ namespace ANNESE {
         return &mCartridge->ROM().at(address);
     }
 
+    const Byte *MapperNROM::getCHRPtr(Address addr) const {
+        return mUsesCHRRAM ? &mCHRRAM[addr] : &mCartridge->VROM()[addr];
+    }
+
 
 }
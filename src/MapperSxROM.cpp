@@ -61,16 +61,19 @@ namespace ANNESE {
                         mBankCHR0 = vromData + 0x1000 * mRegCHR0;
                         mBankCHR1 = vromData + 0x1000 * mRegCHR1;
                     }
+                    switchedCHRBanks();
                 } else if (addr < 0xc000) {
                     mRegCHR0 = mRegTemp;
                     mBankCHR0 = vromData + 0x1000 * (mRegTemp | (1 - mModeCHR));
                     if (mModeCHR == 0) {
                         mBankCHR1 = mBankCHR0 + 0x1000;
                     }
+                    switchedCHRBanks();
                 } else if (addr < 0xe000) {
                     mRegCHR1 = mRegTemp;
                     if (mModeCHR == 1) {
                         mBankCHR1 = vromData + 0x1000 * mRegTemp;
+                        switchedCHRBanks();
                     }
                 } else {
                     if ((mRegTemp & 0x10) == 0x10) {
@@ -114,6 +117,14 @@ namespace ANNESE {
         }
     }
 
+    const Byte *MapperSxROM::getCHRPtr(Address addr) const {
+        if (mUseCharacterRAM) {
+            return &mCharacterRAM[addr];
+        } else {
+            return addr < 0x1000 ? mBankCHR0 + addr : mBankCHR1 + (addr & 0xfff);
+        }
+    }
+
     const Byte *MapperSxROM::getPagePtr(Address addr) const {
         return addr < 0xc000
                ? mBankPRG0 + (addr & 0x3fff)
@@ -143,5 +154,6 @@ namespace ANNESE {
                 mBankPRG0 = data + 0x4000 * mRegPRG;
                 mBankPRG1 = data + mCartridge->ROM().size() - 0x4000;
         }
+        switchedPRGBanks();
     }
 }
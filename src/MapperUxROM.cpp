@@ -17,7 +17,12 @@ namespace ANNESE {
     }
 
     void MapperUxROM::writePRG(Address addr, Byte value) {
-        mSelectPRG = value;
+        //The bits above the number of banks are not connected
+        Address bank = static_cast<Address>(value % (mCartridge->ROM().size() / 0x4000));
+        if (mSelectPRG != bank) {
+            mSelectPRG = bank;
+            switchedPRGBanks();
+        }
     }
 
     Byte MapperUxROM::readPRG(Address addr) const {
@@ -46,4 +51,8 @@ namespace ANNESE {
             return &mLastBankPtr[addr & 0x3fff];
         }
     }
+
+    const Byte *MapperUxROM::getCHRPtr(Address addr) const {
+        return mUseCharacterRAM ? &mCharacterRAM[addr] : &mCartridge->VROM()[addr];
+    }
 }
\ No newline at end of file
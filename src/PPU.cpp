@@ -1,26 +1,139 @@
 #include <cstring>
 #include <cassert>
 #include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "../include/PPU.h"
-#include "../include/PaletteColors.h"
 
 namespace ANNESE {
-    PPU::PPU(std::shared_ptr<ANNESE::PictureBus> pictureBus, std::shared_ptr<ANNESE::Screen> screen)
-            : mPictureBus(std::move(pictureBus)), mScreen(std::move(screen)), mSpriteMemory(64 * 4),
-              mPictureBuffer(ScanlineVisibleDots, std::vector<sf::Color>(VisibleScanlines, sf::Color::Magenta)) {
+    namespace {
+        /// Index of the lowest bit set, the value must not be 0
+        int LowestBit(std::uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_ctzll(value);
+#else
+            int index = 0;
+            for (; !(value & 1); value >>= 1) {
+                ++index;
+            }
+            return index;
+#endif
+        }
+    }
+
+    PPU::PPU(std::shared_ptr<ANNESE::PictureBus> pictureBus, std::shared_ptr<ANNESE::VideoSink> video)
+            : mPictureBus(std::move(pictureBus)), mVideo(std::move(video)),
+              mCompositeScanline(ScanlineCompositor::Select()), mSpriteMemory(64 * 4) {
+    }
+
+    PPU::~PPU() {
+        //The lines still queued are written into mFrames, which goes before the renderer would
+        if (mRenderer) {
+            mRenderer->finish();
+        }
+    }
+
+    void PPU::setRenderer(std::shared_ptr<PPURenderer> renderer) {
+        mRenderer = std::move(renderer);
+        if (mRenderer) {
+            mRenderer->setLayout(mPictureBus->chrPages(), mPictureBus->nameTableMirroring());
+            mRendererLayout = mPictureBus->layoutGeneration();
+        }
     }
 
     void PPU::reset() {
-        mLongSprites = mGenerateInterrupt = mVBlank = false;
+        mLongSprites = mGenerateInterrupt = mVBlank = mNMI = mSprZeroHit = false;
+        mHideEdgeSprites = mHideEdgeBackground = false;
         mShowBackground = mShowSprites = mEvenFrame = mFirstWrite = true;
         mBgPage = mSprPage = CharacterPage::Low;
         mDataAddress = mTempAddress = 0;
-        mCycle = mScanline = mSpriteDataAddress = mFineXScroll = 0;
+        mCycle = mScanline = mSpriteDataAddress = mFineXScroll = mDataBuffer = 0;
         mDataAddrIncrement = 1;
         mPipelineState = State::PreRender;
         mScanlineSprites.reserve(8);
     }
 
+    int PPU::dotsUntilVBlank() const {
+        //Every scanline runs dots 1..ScanlineEndCycle, the pre-render one may be a dot shorter on odd frames.
+        //VBlank starts on the second dot after the post-render scanline ends
+        constexpr int Line = ScanlineEndCycle;
+        constexpr int FromPostRenderStart = Line + 1;
+        constexpr int FromRenderStart = VisibleScanlines * Line + FromPostRenderStart;
+        switch (mPipelineState) {
+            case State::PreRender: {
+                int end = Line - !mEvenFrame;
+                return std::max(end - mCycle, 0) + 1 + FromRenderStart;
+            }
+            case State::Render:
+                return (Line - mCycle + 1) + (VisibleScanlines - 1 - mScanline) * Line + FromPostRenderStart;
+            case State::PostRender:
+                return Line - mCycle + 2;
+            case State::VerticalBlank:
+            default:
+                if (mScanline == VisibleScanlines + 1 && mCycle <= 1) {
+                    return 2 - mCycle;
+                }
+                //The frame parity flips when the pre-render scanline starts
+                return (Line - mCycle + 1) + (FrameEndScanline - 1 - mScanline) * Line +
+                       (Line - mEvenFrame) + FromRenderStart;
+        }
+    }
+
+    int PPU::dotsUntilStatusChange() const {
+        constexpr int Line = ScanlineEndCycle;
+        int vblank = dotsUntilVBlank();
+        switch (mPipelineState) {
+            case State::PreRender: {
+                if (mCycle <= 1) {
+                    //The flags are about to be cleared
+                    return 2 - mCycle;
+                }
+                int hitScanline = spriteZeroHitScanline(0);
+                if (hitScanline < 0) {
+                    return vblank;
+                }
+                int end = Line - !mEvenFrame;
+                return std::min(vblank, std::max(end - mCycle, 0) + 1 + hitScanline * Line + 1);
+            }
+            case State::Render: {
+                int hitScanline = spriteZeroHitScanline(mScanline);
+                if (hitScanline < 0) {
+                    return vblank;
+                } else if (hitScanline == mScanline) {
+                    return 1;
+                }
+                return std::min(vblank, (Line - mCycle + 1) + (hitScanline - mScanline - 1) * Line + 1);
+            }
+            case State::PostRender:
+                return vblank;
+            case State::VerticalBlank:
+            default:
+                //Either the vertical blank starts or the flags are cleared on the second dot of the pre-render scanline
+                return std::min(vblank, (Line - mCycle + 1) + (FrameEndScanline - 1 - mScanline) * Line + 1);
+        }
+    }
+
+    int PPU::spriteZeroHitScanline(int from) const {
+        if (mSprZeroHit || !mShowBackground || !mShowSprites) {
+            return -1;
+        }
+        //The current scanline uses the sprites found on the previous one
+        if (std::find(mScanlineSprites.begin(), mScanlineSprites.end(), 0) != mScanlineSprites.end()) {
+            return from;
+        }
+        //The sprite 0 is never found when the search starts past it
+        if (mSpriteDataAddress >= 4) {
+            return -1;
+        }
+        int range = mLongSprites ? 16 : 8;
+        int first = std::max(from + 1, mSpriteMemory[0] + 1);
+        if (first > mSpriteMemory[0] + range || first >= static_cast<int>(VisibleScanlines)) {
+            return -1;
+        }
+        return first;
+    }
+
     void PPU::doDMA(const Byte *page) {
         assert(mSpriteDataAddress <= 256);
         std::memcpy(mSpriteMemory.data() + mSpriteDataAddress, page, static_cast<size_t>(256 - mSpriteDataAddress));
@@ -48,6 +161,8 @@ namespace ANNESE {
         mHideEdgeSprites = !(mask & 0x4);
         mShowSprites = (mask & 0x10) != 0;
         mShowBackground = (mask & 0x8) != 0;
+        mEmphasis = static_cast<FrameBuffer::Pixel>((mask >> 5) << FrameBuffer::EmphasisShift);
+        mGrayscaleMask = (mask & 0x1) ? Byte(0x30) : Byte(0x3f);
     }
 
     Byte PPU::status() {
@@ -85,6 +200,10 @@ namespace ANNESE {
     }
 
     void PPU::data(Byte data) {
+        if (mRenderer) {
+            updateRendererLayout();
+            mRenderer->write(mDataAddress, data);
+        }
         mPictureBus->write(mDataAddress, data);
         mDataAddress += mDataAddrIncrement;
     }
@@ -120,126 +239,13 @@ namespace ANNESE {
                 //if rendering is on, every other frame is one cycle shorter
                 if (mCycle >= ScanlineEndCycle - (!mEvenFrame && mShowBackground && mShowSprites)) {
                     mPipelineState = State::Render;
-                    mCycle = mScanline = 0;
+                    mCycle = mScanline = mRenderedDots = 0;
+                    mSkippingFrame = mSkipFrames;
                 }
                 break;
             case State::Render:
-                if (mCycle > 0 && mCycle <= ScanlineVisibleDots) {
-                    Byte bgColor = 0, sprColor = 0;
-                    bool bgOpaque = false, sprOpaque = true;
-                    bool sprFg = false;
-
-                    int x = mCycle - 1;
-                    int y = mScanline;
-
-                    if (mShowBackground) {
-                        Byte xFine = (mFineXScroll + x) % Byte(8);
-                        if (!mHideEdgeBackground || x >= 8) {
-                            //fetch tile
-                            Address addr = Address(0x2000) | (mDataAddress & Address(0x0FFF)); //mask off fine y
-                            Byte tile = read(addr);
-
-                            //fetch pattern
-                            //Each pattern occupies 16 bytes, so multiply by 16
-                            addr = (tile * 16) + ((mDataAddress >> 12) & Address(0x7)); //Add fine y
-                            //set whether the pattern is in the high or low page
-                            addr |= static_cast<Address>(mBgPage) << 12;
-                            //Get the corresponding bit determined by (8 - x_fine) from the right
-                            bgColor = (read(addr) >> (7 ^ xFine)) & Byte(1); //bit 0 of palette entry
-                            bgColor |= ((read(addr + Address(8)) >> (7 ^ xFine)) & Byte(1)) << 1; //bit 1
-
-                            bgOpaque = bgColor; //flag used to calculate final pixel with the sprite pixel
-
-                            //fetch attribute and calculate higher two bits of palette
-                            addr = Address(0x23C0) | (mDataAddress & 0x0C00) | ((mDataAddress >> 4) & 0x38)
-                                   | ((mDataAddress >> 2) & 0x07);
-                            auto attribute = read(addr);
-                            int shift = ((mDataAddress >> 4) & 4) | (mDataAddress & 2);
-                            //Extract and set the upper two bits for the color
-                            bgColor |= ((attribute >> shift) & 0x3) << 2;
-                        }
-                        //Increment/wrap coarse X
-                        if (xFine == 7) {
-                            if ((mDataAddress & 0x001F) == 31) {    // if coarse X == 31
-                                mDataAddress &= ~0x001F;    // coarse X = 0
-                                mDataAddress ^= 0x0400;     // switch horizontal nametable
-                            } else {
-                                mDataAddress += 1;  // increment coarse X
-                            }
-                        }
-                    }
-
-                    if (mShowSprites && (!mHideEdgeSprites || x >= 8)) {
-                        for (Byte i : mScanlineSprites) {
-                            Byte sprX = mSpriteMemory[i * 4 + 3];
-
-                            if (x - sprX < 0 || x - sprX >= 8) {
-                                continue;
-                            }
-
-                            Byte sprY      = mSpriteMemory[i * 4 + 0] + Byte(1);
-                            Byte tile      = mSpriteMemory[i * 4 + 1];
-                            Byte attribute = mSpriteMemory[i * 4 + 2];
-
-                            int length = (mLongSprites) ? 16 : 8;
-
-                            int xShift = (x - sprX) % 8;
-                            int yOffset = (y - sprY) % length;
-
-                            //If NOT flipping horizontally
-                            if ((attribute & 0x40) == 0) {
-                                xShift ^= 7;
-                            }
-                            //IF flipping vertically
-                            if ((attribute & 0x80) != 0) {
-                                yOffset ^= (length - 1);
-                            }
-                            Address addr = 0;
-
-                            if (!mLongSprites) {
-                                addr = tile * Address(16) + yOffset;
-                                if (mSprPage == CharacterPage::High) {
-                                    addr += 0x1000;
-                                }
-                            } else {    //8x16 sprites
-                                //bit-3 is one if it is the bottom tile of the sprite,
-                                // multiply by two to get the next pattern
-                                yOffset = (yOffset & 7) | ((yOffset & 8) << 1);
-                                addr = (tile >> 1) * Address(32) + yOffset;
-                                addr |= (tile & 1) << 12; //Bank 0x1000 if bit-0 is high
-                            }
-
-                            sprColor |= (read(addr) >> (xShift)) & 1; //bit 0 of palette entry
-                            sprColor |= ((read(addr + Address(8)) >> (xShift)) & 1) << 1; //bit 1
-
-                            sprOpaque = sprColor != 0;
-                            if (!sprOpaque) {
-                                continue;
-                            }
-
-                            sprColor |= 0x10; //Select sprite palette
-                            sprColor |= (attribute & 0x3) << 2; //bits 2-3
-
-                            sprFg = !(attribute & 0x20);
-
-                            //Sprite-0 hit detection
-                            if (!mSprZeroHit && mShowBackground && i == 0 && bgOpaque) {
-                                mSprZeroHit = true;
-                            }
-                            break; //Exit the loop now since we've found the highest priority sprite
-                        }
-                    }
-
-                    Byte paletteAddr = bgColor;
-
-                    if ( (!bgOpaque && sprOpaque) ||
-                         (bgOpaque && sprOpaque && sprFg) ) {
-                        paletteAddr = sprColor;
-                    } else if (!bgOpaque) {
-                        paletteAddr = 0;
-                    }
-
-                    mPictureBuffer[x][y] = sf::Color(PaletteColors[mPictureBus->readPalette(paletteAddr)]);
+                if (mCycle == ScanlineVisibleDots) {
+                    renderPixels(ScanlineVisibleDots);
                 } else if (mCycle == ScanlineVisibleDots + 1 && mShowBackground) {
                     //Shamelessly copied from nesdev wiki
                     if ((mDataAddress & 0x7000) != 0x7000) {  // if fine Y < 7
@@ -270,20 +276,16 @@ namespace ANNESE {
                     //but (I think) it shouldn't hurt any games if this is done here
 
                     mScanlineSprites.resize(0);
-                    int range = mLongSprites ? 16 : 8;
-
-                    for (Byte i = mSpriteDataAddress / Byte(4), j = 0; i < 64; ++i) {
-                        int diff = (mScanline - mSpriteMemory[i * 4]);
-                        if (diff >= 0 && diff < range) {
-                            mScanlineSprites.push_back(i);
-                            ++j;
-                            if (j >= 8) {
-                                break;
-                            }
-                        }
+                    //The search starts at the sprite OAMADDR points to
+                    int first = mSpriteDataAddress / 4;
+                    std::uint64_t found = spritesInRange(mScanline) >> first << first;
+                    for (; found && mScanlineSprites.size() < 8; found &= found - 1) {
+                        mScanlineSprites.push_back(static_cast<Byte>(LowestBit(found)));
                     }
+                    mSpriteLineValid = false;
                     ++mScanline;
                     mCycle = 0;
+                    mRenderedDots = 0;
                 }
                 if (mScanline >= VisibleScanlines) {
                     mPipelineState = State::PostRender;
@@ -294,20 +296,20 @@ namespace ANNESE {
                     ++mScanline;
                     mCycle = 0;
                     mPipelineState = State::VerticalBlank;
-                    for (int x = 0; x < ScanlineVisibleDots; ++x) {
-                        for (int y = 0; y < VisibleScanlines; ++y) {
-                            mScreen->setPixel({x, y}, mPictureBuffer[x][y]);
+                    if (!mSkippingFrame) {
+                        if (mRenderer) {
+                            mRenderer->finish();
                         }
+                        std::swap(mFrontFrame, mBackFrame);
+                        mVideo->setPicture(mFrames[mFrontFrame]);
                     }
                 }
                 break;
             case State::VerticalBlank:
                 if (mCycle == 1 && mScanline == VisibleScanlines + 1) {
                     mVBlank = true;
-                    if (mGenerateInterrupt) {
-                        assert(mVBlankCallback);
-                        mVBlankCallback();
-                    }
+                    ++mFrameCount;
+                    mNMI = mGenerateInterrupt;
                 }
                 if (mCycle >= ScanlineEndCycle) {
                     ++mScanline;
@@ -321,4 +323,264 @@ namespace ANNESE {
         }
         ++mCycle;
     }
-}
\ No newline at end of file
+
+    std::uint64_t PPU::spritesInRange(int scanline) const {
+#ifdef __SSE2__
+        int range = mLongSprites ? 16 : 8;
+        std::uint64_t found = 0;
+        //The sprite is in range when its Y <= scanline and scanline - Y < range, all in unsigned bytes
+        const __m128i line = _mm_set1_epi8(static_cast<char>(scanline));
+        const __m128i last = _mm_set1_epi8(static_cast<char>(range - 1));
+        for (int i = 0; i < 16; ++i) {
+            //4 sprites, only the Y bytes matter
+            __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&mSpriteMemory[i * 16]));
+            __m128i diff = _mm_sub_epi8(line, y);
+            __m128i above = _mm_cmpeq_epi8(_mm_max_epu8(y, line), line);
+            __m128i near = _mm_cmpeq_epi8(_mm_min_epu8(diff, last), diff);
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(above, near)));
+            mask = (mask & 0x1) | (mask >> 3 & 0x2) | (mask >> 6 & 0x4) | (mask >> 9 & 0x8);
+            found |= static_cast<std::uint64_t>(mask) << (i * 4);
+        }
+        return found;
+#else
+        return spritesInRangeScalar(scanline);
+#endif
+    }
+
+    std::uint64_t PPU::spritesInRangeScalar(int scanline) const {
+        int range = mLongSprites ? 16 : 8;
+        std::uint64_t found = 0;
+        for (int i = 0; i < 64; ++i) {
+            int diff = scanline - mSpriteMemory[i * 4];
+            if (diff >= 0 && diff < range) {
+                found |= std::uint64_t(1) << i;
+            }
+        }
+        return found;
+    }
+
+    void PPU::flush() {
+        //Whatever comes next may change the sprites
+        mSpriteLineValid = false;
+        if (mPipelineState == State::Render) {
+            //The pixel of a dot is produced once the dot has been stepped
+            int end = std::min(mCycle - 1, static_cast<int>(ScanlineVisibleDots));
+            if (end > mRenderedDots) {
+                renderPixels(end);
+            }
+        }
+    }
+
+    void PPU::renderPixels(int end) {
+        if (mRenderedDots == 0 && end == ScanlineVisibleDots) {
+            if (mSkippingFrame) {
+                skipScanline();
+            } else if (mRenderer) {
+                updateRendererLayout();
+                mRenderer->render(scanlineState(), mFrames[mBackFrame].row(mScanline));
+                skipScanline();
+            } else {
+                renderScanline();
+            }
+        } else {
+            for (int x = mRenderedDots; x < end; ++x) {
+                renderDot(x);
+            }
+        }
+        mRenderedDots = end;
+    }
+
+    void PPU::skipScanline() {
+        if (!mSprZeroHit && spriteZeroHitsBackground()) {
+            mSprZeroHit = true;
+        }
+        if (mShowBackground) {
+            //What the 32 coarse X increments of a rendered line add up to, once the background has been looked at
+            mDataAddress ^= 0x0400;
+        }
+    }
+
+    bool PPU::spriteZeroHitsBackground() {
+        if (!mShowBackground || !mShowSprites || mScanlineSprites.empty() || mScanlineSprites[0] != 0) {
+            return false;
+        }
+
+        //Only the sprite 0 row and the background under it matter
+        int length = mLongSprites ? 16 : 8;
+        Byte sprX      = mSpriteMemory[3];
+        Byte sprY      = mSpriteMemory[0] + Byte(1);
+        Byte tile      = mSpriteMemory[1];
+        Byte attribute = mSpriteMemory[2];
+        int yOffset = (mScanline - sprY) % length;
+        if ((attribute & 0x80) != 0) {
+            yOffset ^= (length - 1);
+        }
+        Address addr = 0;
+        if (!mLongSprites) {
+            addr = tile * Address(16) + yOffset;
+            if (mSprPage == CharacterPage::High) {
+                addr += 0x1000;
+            }
+        } else {
+            yOffset = (yOffset & 7) | ((yOffset & 8) << 1);
+            addr = (tile >> 1) * Address(32) + yOffset;
+            addr |= (tile & 1) << 12;
+        }
+        std::uint64_t sprite = readPatternRow(addr);
+
+        int firstX = (mHideEdgeSprites || mHideEdgeBackground) ? 8 : 0;
+        for (int column = 0; column < 8; ++column) {
+            int x = sprX + column;
+            if (x >= static_cast<int>(ScanlineVisibleDots)) {
+                break;
+            }
+            int pixel = (attribute & 0x40) ? column ^ 7 : column;
+            if (x < firstX || !static_cast<Byte>(sprite >> (pixel * 8))) {
+                continue;
+            }
+            //The tile the background shows at x, past the end of the name table in the next one
+            int offset = mFineXScroll + x;
+            int coarseX = (mDataAddress & 0x1f) + offset / 8;
+            Address tileAddr = Address(0x2000) | (mDataAddress & Address(0x0FFF));
+            tileAddr = (tileAddr & ~0x1f) | (coarseX & 0x1f);
+            if (coarseX >= 32) {
+                tileAddr ^= 0x0400;
+            }
+            Address patternAddr = (read(tileAddr) * 16) + ((mDataAddress >> 12) & Address(0x7));
+            patternAddr |= static_cast<Address>(mBgPage) << 12;
+            if (static_cast<Byte>(readPatternRow(patternAddr) >> ((offset % 8) * 8))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void PPU::renderScanline() {
+        FrameBuffer::Pixel *row = mFrames[mBackFrame].row(mScanline);
+        if (ScanlineRenderer::Render(scanlineState(), *mPictureBus, mCompositeScanline, row)) {
+            mSprZeroHit = true;
+        }
+        if (mShowBackground) {
+            //The renderer works on a copy of the VRAM address, it ends up in the next name table
+            mDataAddress ^= 0x0400;
+        }
+    }
+
+    ScanlineState PPU::scanlineState() const {
+        ScanlineState line;
+        line.scanline = mScanline;
+        line.dataAddress = mDataAddress;
+        line.fineXScroll = mFineXScroll;
+        line.bgPage = static_cast<Address>(mBgPage) << 12;
+        line.sprPage = static_cast<Address>(mSprPage) << 12;
+        line.longSprites = mLongSprites;
+        line.showBackground = mShowBackground;
+        line.showSprites = mShowSprites;
+        line.hideEdgeBackground = mHideEdgeBackground;
+        line.hideEdgeSprites = mHideEdgeSprites;
+        line.grayscaleMask = mGrayscaleMask;
+        line.emphasis = mEmphasis;
+        line.spriteCount = mScanlineSprites.size();
+        for (std::size_t i = 0; i < mScanlineSprites.size(); ++i) {
+            const Byte *sprite = &mSpriteMemory[mScanlineSprites[i] * 4];
+            line.sprites[i] = {mScanlineSprites[i], sprite[0], sprite[1], sprite[2], sprite[3]};
+        }
+        return line;
+    }
+
+    void PPU::updateRendererLayout() {
+        if (mRendererLayout != mPictureBus->layoutGeneration()) {
+            mRenderer->setLayout(mPictureBus->chrPages(), mPictureBus->nameTableMirroring());
+            mRendererLayout = mPictureBus->layoutGeneration();
+        }
+    }
+
+    void PPU::rasterizeSprites() {
+        ScanlineRenderer::RasterizeSprites(scanlineState(), *mPictureBus, mSpriteLine.data());
+        mSpriteLineValid = true;
+    }
+
+    void PPU::fetchBackgroundTile() {
+        //fetch tile
+        Address addr = Address(0x2000) | (mDataAddress & Address(0x0FFF)); //mask off fine y
+        Byte tile = read(addr);
+
+        //fetch pattern
+        //Each pattern occupies 16 bytes, so multiply by 16
+        addr = (tile * 16) + ((mDataAddress >> 12) & Address(0x7)); //Add fine y
+        //set whether the pattern is in the high or low page
+        addr |= static_cast<Address>(mBgPage) << 12;
+        mBgPatternLow |= read(addr);
+        mBgPatternHigh |= read(addr + Address(8));
+
+        //fetch attribute and spread the two bits of the palette over the tile
+        addr = Address(0x23C0) | (mDataAddress & 0x0C00) | ((mDataAddress >> 4) & 0x38)
+               | ((mDataAddress >> 2) & 0x07);
+        auto attribute = read(addr);
+        int shift = ((mDataAddress >> 4) & 4) | (mDataAddress & 2);
+        mBgAttributeLow |= ((attribute >> shift) & 0x1) ? 0xff : 0;
+        mBgAttributeHigh |= ((attribute >> shift) & 0x2) ? 0xff : 0;
+
+        incrementCoarseX();
+    }
+
+    void PPU::incrementCoarseX() {
+        ScanlineRenderer::IncrementCoarseX(mDataAddress);
+    }
+
+    void PPU::renderDot(int x) {
+        Byte bgColor = 0;
+        bool bgOpaque = false;
+
+        if (mShowBackground) {
+            //The first two tiles are loaded at once, then the next one every 8 dots.
+            //The 33rd tile shows only when fine X isn't 0, and like ScanlineRenderer the line advances coarse X
+            //just 32 times, so it is fetched without moving on
+            if (x == 0) {
+                mBgPatternLow = mBgPatternHigh = mBgAttributeLow = mBgAttributeHigh = 0;
+                fetchBackgroundTile();
+                mBgPatternLow <<= 8;
+                mBgPatternHigh <<= 8;
+                mBgAttributeLow <<= 8;
+                mBgAttributeHigh <<= 8;
+                fetchBackgroundTile();
+            } else if (x == static_cast<int>(ScanlineVisibleDots) - 8) {
+                Address dataAddress = mDataAddress;
+                fetchBackgroundTile();
+                mDataAddress = dataAddress;
+            } else if (x % 8 == 0) {
+                fetchBackgroundTile();
+            }
+
+            int bit = 15 - mFineXScroll;
+            if (!mHideEdgeBackground || x >= 8) {
+                bgColor = ((mBgPatternLow >> bit) & 1) | ((mBgPatternHigh >> bit) & 1) << 1;
+                bgOpaque = bgColor;
+                bgColor |= ((mBgAttributeLow >> bit) & 1) << 2 | ((mBgAttributeHigh >> bit) & 1) << 3;
+            }
+            mBgPatternLow <<= 1;
+            mBgPatternHigh <<= 1;
+            mBgAttributeLow <<= 1;
+            mBgAttributeHigh <<= 1;
+        }
+
+        Byte sprite = 0;
+        if (mShowSprites && (!mHideEdgeSprites || x >= 8)) {
+            if (!mSpriteLineValid) {
+                rasterizeSprites();
+            }
+            sprite = mSpriteLine[x];
+            //Sprite-0 hit detection
+            if (!mSprZeroHit && mShowBackground && (sprite & ScanlineCompositor::SpriteZero) && bgOpaque) {
+                mSprZeroHit = true;
+            }
+        }
+
+        Byte paletteAddr = bgOpaque ? bgColor : Byte(0);
+        if (sprite && (!bgOpaque || !(sprite & ScanlineCompositor::BehindBackground))) {
+            paletteAddr = sprite & Byte(0x1f);
+        }
+
+        mFrames[mBackFrame].row(mScanline)[x] = pixel(paletteAddr);
+    }
+}
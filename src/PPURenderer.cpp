@@ -0,0 +1,151 @@
+#include "../include/PPURenderer.h"
+
+namespace ANNESE {
+    /// Stands for the cartridge in the copy of the PPU memory: the CHR ROM is shared as it never changes,
+    /// the CHR RAM is a copy of its own
+    class PPURenderer::CHRCopy : public CHRMemory {
+    public:
+        explicit CHRCopy(bool chrRAM)
+                : mUsesCHRRAM(chrRAM), mCHRRAM(0x2000) {
+            for (std::size_t page = 0; page < mCHRPages.size(); ++page) {
+                mCHRPages[page] = &mCHRRAM[page << 10];
+            }
+        }
+
+        void writeCHR(Address addr, Byte value) override {
+            if (mUsesCHRRAM) {
+                mCHRRAM[addr] = value;
+            }
+        }
+
+        const Byte *getCHRPtr(Address addr) const override {
+            return mCHRPages[addr >> 10] + (addr & 0x3ff);
+        }
+
+        /// Only until the first layout arrives
+        NameTableMirroring nameTableMirroring() const override {
+            return NameTableMirroring::Horizontal;
+        }
+
+        /// The pages of the CHR ROM, the CHR RAM stays where it is
+        void setCHRPages(const std::array<const Byte *, 8> &pages) {
+            if (!mUsesCHRRAM && pages != mCHRPages) {
+                mCHRPages = pages;
+                switchedCHRBanks();
+            }
+        }
+
+    protected:
+        bool mUsesCHRRAM;
+
+        std::vector<Byte> mCHRRAM;
+
+        std::array<const Byte *, 8> mCHRPages{};
+    };
+
+    PPURenderer::PPURenderer(bool chrRAM)
+            : mCHR(std::make_shared<CHRCopy>(chrRAM)), mComposite(ScanlineCompositor::Select()),
+              mQueue(new Command[QueueSize]) {
+        mMemory.setCHRMemory(mCHR);
+        mThread = std::thread(&PPURenderer::run, this);
+    }
+
+    PPURenderer::~PPURenderer() {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mWakeUp.notify_one();
+        mThread.join();
+    }
+
+    void PPURenderer::write(Address addr, Byte value) {
+        Command command{};
+        command.type = Command::Type::Write;
+        command.addr = addr;
+        command.value = value;
+        push(command);
+    }
+
+    void PPURenderer::setLayout(const std::array<const Byte *, 8> &chrPages, CHRMemory::NameTableMirroring mirroring) {
+        Command command{};
+        command.type = Command::Type::Layout;
+        command.chrPages = chrPages;
+        command.mirroring = mirroring;
+        push(command);
+    }
+
+    void PPURenderer::render(const ScanlineState &line, FrameBuffer::Pixel *row) {
+        Command command{};
+        command.type = Command::Type::Render;
+        command.line = line;
+        command.row = row;
+        push(command);
+    }
+
+    void PPURenderer::finish() {
+        std::size_t tail = mTail.load(std::memory_order_relaxed);
+        while (mHead.load(std::memory_order_acquire) != tail) {
+            std::this_thread::yield();
+        }
+    }
+
+    void PPURenderer::push(const Command &command) {
+        std::size_t tail = mTail.load(std::memory_order_relaxed);
+        while (tail - mHead.load(std::memory_order_acquire) == QueueSize) {
+            std::this_thread::yield();
+        }
+        mQueue[tail % QueueSize] = command;
+        //Either the worker sees the command before it goes to sleep or it is seen sleeping here
+        mTail.store(tail + 1, std::memory_order_seq_cst);
+        if (mSleeping.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mWakeUp.notify_one();
+        }
+    }
+
+    void PPURenderer::run() {
+        int polls = 0;
+        while (true) {
+            std::size_t head = mHead.load(std::memory_order_relaxed);
+            if (head != mTail.load(std::memory_order_acquire)) {
+                execute(mQueue[head % QueueSize]);
+                mHead.store(head + 1, std::memory_order_release);
+                polls = 0;
+                continue;
+            }
+            if (++polls < PollsBeforeSleep) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mMutex);
+            mSleeping.store(true, std::memory_order_seq_cst);
+            mWakeUp.wait(lock, [this, head]() {
+                return mStop || mTail.load(std::memory_order_seq_cst) != head;
+            });
+            mSleeping.store(false, std::memory_order_relaxed);
+            if (mStop) {
+                return;
+            }
+            polls = 0;
+        }
+    }
+
+    void PPURenderer::execute(const Command &command) {
+        switch (command.type) {
+            case Command::Type::Write:
+                mMemory.write(command.addr, command.value);
+                break;
+            case Command::Type::Layout:
+                mCHR->setCHRPages(command.chrPages);
+                if (command.mirroring != mMemory.nameTableMirroring()) {
+                    mMemory.setMirroring(command.mirroring);
+                }
+                break;
+            case Command::Type::Render:
+                ScanlineRenderer::Render(command.line, mMemory, mComposite, command.row);
+                break;
+        }
+    }
+}
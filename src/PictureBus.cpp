@@ -26,13 +26,10 @@
 
 namespace ANNESE {
     PictureBus::PictureBus()
-            : mRAM(0x800), mPalette(0x20){
+            : mRAM(0x800) {
     }
 
-    Byte PictureBus::read(Address addr) const {
-        if (IN_CHRROM(addr)) {
-            return mMapper->readCHR(addr);
-        }
+    Byte PictureBus::readVRAM(Address addr) const {
         Address rel = addr & Address(0x3ff);
         if (IN_VRAM0(addr)) {
             return mRAM[mVRAM0 + rel];
@@ -48,7 +45,7 @@ namespace ANNESE {
         }
         assert(!IN_VRAMMirror(addr));
         if (IN_PaletteSP(addr) | IN_PaletteBG(addr)) {
-            return mPalette.at(addr & Address(0x1f));
+            return readPalette(static_cast<Byte>(addr));
         }
         return 0;
     }
@@ -56,7 +53,8 @@ namespace ANNESE {
     void PictureBus::write(Address addr, Byte value) {
         Address rel = addr & Address(0x3ff);
         if (IN_CHRROM(addr)) {
-            mMapper->writeCHR(addr, value);
+            mCHRMemory->writeCHR(addr, value);
+            mDecodedCHRPages[addr >> 10]->valid &= ~(1ull << ((addr >> 4) & 0x3f));
         } else if (IN_VRAM0(addr)) {
             mRAM[mVRAM0 + rel] = value;
         } else if (IN_VRAM1(addr)) {
@@ -68,53 +66,96 @@ namespace ANNESE {
         } else if (IN_VRAMMirror(addr)) {
             assert(false);
         } else if (IN_PaletteSP(addr) | IN_PaletteBG(addr)) {
-            if (addr == static_cast<Address>(MemoryMap::PaletteSP)) {
-                mPalette[0] = value;
-            } else {
-                mPalette.at(addr & Address(0x1f)) = value;
+            Byte entry = static_cast<Byte>(addr & 0x1f);
+            mPalette[entry] = value & Byte(0x3f);
+            //The first color of every sprite palette is the one of the background palette below it
+            if ((entry & 0x3) == 0) {
+                mPalette[entry ^ 0x10] = mPalette[entry];
             }
         } else {
             assert(false);
         }
     }
 
-    bool PictureBus::setMapper(std::shared_ptr<Mapper> mapper) {
-        if (!mapper) {
+    bool PictureBus::setCHRMemory(std::shared_ptr<CHRMemory> chrMemory) {
+        if (!chrMemory) {
             return false;
         }
-        mMapper = mapper;
+        mCHRMemory = std::move(chrMemory);
+        mDecodedCHR.clear();
+        mCHRMemory->setCHRBankCallback([this]() {
+            updateCHRPages();
+        });
+        updateCHRPages();
         updateMirroring();
         return true;
     }
 
-    Byte PictureBus::readPalette(Byte paletteAddr) {
-        return mPalette.at(paletteAddr);
+    void PictureBus::updateCHRPages() {
+        for (std::size_t page = 0; page < mCHRPages.size(); ++page) {
+            mCHRPages[page] = mCHRMemory->getCHRPtr(static_cast<Address>(page << 10));
+            mDecodedCHRPages[page] = &mDecodedCHR[mCHRPages[page]];
+        }
+        ++mLayoutGeneration;
+    }
+
+    void PictureBus::decodeTile(DecodedPage &page, Address addr) {
+        const Byte *pattern = mCHRPages[addr >> 10] + (addr & 0x3f0);
+        std::uint64_t *rows = &page.rows[(addr >> 1) & 0x1f8];
+        for (int y = 0; y < 8; ++y) {
+            std::uint64_t row = 0;
+            for (int x = 0; x < 8; ++x) {
+                std::uint64_t color = ((pattern[y] >> (7 ^ x)) & 1) | ((pattern[y + 8] >> (7 ^ x)) & 1) << 1;
+                row |= color << (x * 8);
+            }
+            rows[y] = row;
+        }
+        page.valid |= 1ull << ((addr >> 4) & 0x3f);
     }
 
     void PictureBus::updateMirroring() {
-        switch (mMapper->nameTableMirroring()) {
-            case Mapper::NameTableMirroring::Horizontal:
-                mVRAM0 = mVRAM1 = 0;
-                mVRAM2 = mVRAM3 = 0x400;
+        CHRMemory::NameTableMirroring mirroring = mCHRMemory->nameTableMirroring();
+        if (!setMirroring(mirroring)) {
+            Log(Error) << "Unsupported Name Table mirroring: " << static_cast<Byte>(mirroring) << std::endl;
+            return;
+        }
+        switch (mirroring) {
+            case CHRMemory::NameTableMirroring::Horizontal:
                 Log(Debug) << "Horizontal mirroring set" << std::endl;
                 break;
-            case Mapper::NameTableMirroring::Vertical:
-                mVRAM0 = mVRAM2 = 0;
-                mVRAM1 = mVRAM3 = 0x400;
+            case CHRMemory::NameTableMirroring::Vertical:
                 Log(Debug) << "Vertical mirroring set" << std::endl;
                 break;
-            case Mapper::NameTableMirroring::OneScreenLower:
-                mVRAM0 = mVRAM1 = mVRAM2 = mVRAM3 = 0;
+            case CHRMemory::NameTableMirroring::OneScreenLower:
                 Log(Debug) << "One Screen Lower mirroring set" << std::endl;
                 break;
-            case Mapper::NameTableMirroring::OneScreenHigher:
-                mVRAM0 = mVRAM1 = mVRAM2 = mVRAM3 = 0x400;
+            case CHRMemory::NameTableMirroring::OneScreenHigher:
+            default:
                 Log(Debug) << "One Screen Higher mirroring set" << std::endl;
-                break;
+        }
+    }
+
+    bool PictureBus::setMirroring(CHRMemory::NameTableMirroring mirroring) {
+        mMirroring = mirroring;
+        ++mLayoutGeneration;
+        switch (mirroring) {
+            case CHRMemory::NameTableMirroring::Horizontal:
+                mVRAM0 = mVRAM1 = 0;
+                mVRAM2 = mVRAM3 = 0x400;
+                return true;
+            case CHRMemory::NameTableMirroring::Vertical:
+                mVRAM0 = mVRAM2 = 0;
+                mVRAM1 = mVRAM3 = 0x400;
+                return true;
+            case CHRMemory::NameTableMirroring::OneScreenLower:
+                mVRAM0 = mVRAM1 = mVRAM2 = mVRAM3 = 0;
+                return true;
+            case CHRMemory::NameTableMirroring::OneScreenHigher:
+                mVRAM0 = mVRAM1 = mVRAM2 = mVRAM3 = 0x400;
+                return true;
             default:
                 mVRAM0 = mVRAM1 = mVRAM2 = mVRAM3 = 0;
-                Log(Error) << "Unsupported Name Table mirroring: "
-                           << static_cast<Byte>(mMapper->nameTableMirroring()) << std::endl;
+                return false;
         }
     }
 }
\ No newline at end of file
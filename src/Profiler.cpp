@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include "../include/Profiler.h"
+
+namespace ANNESE {
+    namespace {
+        //In the order of CPU::Interruption
+        constexpr const char *InterruptNames[] = {"IRQ", "NMI", "BRK"};
+    }
+
+    Profiler::Profiler() {
+        clear();
+    }
+
+    void Profiler::instruction(Address pc, int bank, Operation op, CycleLength cycles) {
+        Counters &counters = mInstructions[Location(pc, bank)];
+        ++counters.executions;
+        counters.cycles += cycles;
+        mBankCycles[bank] += cycles;
+        mNodes[mStack.back()].cycles += cycles;
+        mTotalCycles += cycles;
+        if (!mInterrupts.empty()) {
+            mInterruptCounters[static_cast<int>(mInterrupts.back())].cycles += cycles;
+        }
+
+        if (op == Operation::RTS) {
+            //Some code returns by other means than RTS, so never return from an interrupt handler this way
+            if (mStack.size() > 1 && !(mNodes[mStack.back()].frame & InterruptFrame)) {
+                pop();
+            }
+        } else if (op == Operation::RTI) {
+            while (mStack.size() > 1 && !(mNodes[mStack.back()].frame & InterruptFrame)) {
+                pop();
+            }
+            if (mStack.size() > 1) {
+                pop();
+                mInterrupts.pop_back();
+            }
+        }
+    }
+
+    void Profiler::call(Address target, int bank) {
+        push(Location(target, bank));
+    }
+
+    void Profiler::interrupt(CPU::Interruption inter, Address handler, int bank, CycleLength cycles) {
+        push(InterruptFrame | static_cast<std::uint32_t>(inter) << 24 | Location(handler, bank));
+        mInterrupts.push_back(inter);
+
+        Counters &counters = mInterruptCounters[static_cast<int>(inter)];
+        ++counters.executions;
+        counters.cycles += cycles;
+        mNodes[mStack.back()].cycles += cycles;
+        mTotalCycles += cycles;
+    }
+
+    void Profiler::clear() {
+        mInstructions.clear();
+        mBankCycles.clear();
+        mNodes.assign(1, StackNode{0, 0, 0});
+        mChildren.clear();
+        mStack.assign(1, 0);
+        mInterrupts.clear();
+        std::fill(std::begin(mInterruptCounters), std::end(mInterruptCounters), Counters{});
+        mTotalCycles = 0;
+    }
+
+    void Profiler::writeFoldedStacks(std::ostream &os) const {
+        std::vector<std::string> names(mNodes.size());
+        names[0] = "reset";
+        //A parent is always created before its children
+        for (std::size_t i = 1; i < mNodes.size(); ++i) {
+            names[i] = names[mNodes[i].parent] + ';' + FrameName(mNodes[i].frame);
+        }
+        for (std::size_t i = 0; i < mNodes.size(); ++i) {
+            if (mNodes[i].cycles) {
+                os << names[i] << ' ' << mNodes[i].cycles << '\n';
+            }
+        }
+    }
+
+    void Profiler::writeSummary(std::ostream &os, std::size_t count) const {
+        auto percent = [this](std::uint64_t cycles) {
+            return mTotalCycles ? 100.0 * cycles / mTotalCycles : 0.0;
+        };
+
+        std::vector<std::pair<std::uint32_t, Counters>> instructions(mInstructions.begin(), mInstructions.end());
+        count = std::min(count, instructions.size());
+        std::partial_sort(instructions.begin(), instructions.begin() + count, instructions.end(),
+                          [](const auto &a, const auto &b) {
+                              return a.second.cycles > b.second.cycles;
+                          });
+
+        std::ios_base::fmtflags flags = os.flags();
+        std::streamsize precision = os.precision();
+        os << "Total cycles: " << mTotalCycles << '\n';
+        os << std::left << std::setw(12) << "Address" << std::right << std::setw(14) << "Executions"
+           << std::setw(14) << "Cycles" << std::setw(9) << "%" << '\n';
+        os << std::fixed << std::setprecision(2);
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto &[location, counters] = instructions[i];
+            os << std::left << std::setw(12) << FrameName(location) << std::right << std::setw(14)
+               << counters.executions << std::setw(14) << counters.cycles << std::setw(9)
+               << percent(counters.cycles) << '\n';
+        }
+
+        std::vector<std::pair<int, std::uint64_t>> banks(mBankCycles.begin(), mBankCycles.end());
+        std::sort(banks.begin(), banks.end());
+        os << "\nBanks:\n";
+        for (const auto &[bank, cycles] : banks) {
+            os << std::left << std::setw(12) << (bank < 0 ? std::string("RAM") : "b" + std::to_string(bank))
+               << std::right << std::setw(28) << cycles << std::setw(9) << percent(cycles) << '\n';
+        }
+
+        os << "\nInterrupt handlers:\n";
+        for (int i = 0; i < 3; ++i) {
+            os << std::left << std::setw(12) << InterruptNames[i] << std::right << std::setw(14)
+               << mInterruptCounters[i].executions << std::setw(14) << mInterruptCounters[i].cycles
+               << std::setw(9) << percent(mInterruptCounters[i].cycles) << '\n';
+        }
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+    std::uint32_t Profiler::Location(Address pc, int bank) {
+        return static_cast<std::uint32_t>(bank + 1) << 16 | pc;
+    }
+
+    std::string Profiler::FrameName(std::uint32_t frame) {
+        std::ostringstream name;
+        if (frame & InterruptFrame) {
+            name << InterruptNames[(frame >> 24) & 0x7f] << '@';
+        }
+        int bank = static_cast<int>((frame >> 16) & 0xff) - 1;
+        if (bank >= 0) {
+            name << 'b' << bank << ':';
+        }
+        name << '$' << std::hex << std::uppercase << std::setw(4) << std::setfill('0') << (frame & 0xffff);
+        return name.str();
+    }
+
+    void Profiler::push(std::uint32_t frame) {
+        if (mStack.size() >= MaxStackDepth) {
+            mStack.resize(1);
+            mInterrupts.clear();
+        }
+
+        std::size_t parent = mStack.back();
+        auto it = mChildren.find(static_cast<std::uint64_t>(parent) << 32 | frame);
+        if (it == mChildren.end()) {
+            mNodes.push_back({parent, frame, 0});
+            it = mChildren.emplace(static_cast<std::uint64_t>(parent) << 32 | frame, mNodes.size() - 1).first;
+        }
+        mStack.push_back(it->second);
+    }
+
+    void Profiler::pop() {
+        mStack.pop_back();
+    }
+}
@@ -0,0 +1,113 @@
+#include "../include/ScanlineCompositor.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ANNESE_X86
+#endif
+
+namespace ANNESE {
+    bool ScanlineCompositor::CompositeScalar(const Byte *background, const Byte *sprites,
+                                             bool hideEdgeBackground, bool hideEdgeSprites, Byte *paletteAddrs) {
+        bool spriteZeroHit = false;
+        for (unsigned x = 0; x < Width; ++x) {
+            Byte bg = hideEdgeBackground && x < 8 ? 0 : background[x];
+            Byte spr = hideEdgeSprites && x < 8 ? 0 : sprites[x];
+            paletteAddrs[x] = spr && (!bg || !(spr & BehindBackground)) ? spr & Byte(0x1f) : bg;
+            spriteZeroHit |= (spr & SpriteZero) && bg;
+        }
+        return spriteZeroHit;
+    }
+
+#ifdef ANNESE_X86
+    namespace {
+        //Zero over the 8 leftmost pixels, all ones elsewhere
+        alignas(32) constexpr Byte EdgeMask[32] = {
+                0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        };
+
+        __attribute__((target("sse2")))
+        bool CompositeSSE2(const Byte *background, const Byte *sprites,
+                           bool hideEdgeBackground, bool hideEdgeSprites, Byte *paletteAddrs) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i behindFlag = _mm_set1_epi8(ScanlineCompositor::BehindBackground);
+            const __m128i zeroFlag = _mm_set1_epi8(ScanlineCompositor::SpriteZero);
+            const __m128i addrMask = _mm_set1_epi8(0x1f);
+            __m128i hits = zero;
+            for (unsigned x = 0; x < ScanlineCompositor::Width; x += 16) {
+                __m128i bg = _mm_loadu_si128(reinterpret_cast<const __m128i *>(background + x));
+                __m128i spr = _mm_loadu_si128(reinterpret_cast<const __m128i *>(sprites + x));
+                if (x == 0) {
+                    __m128i edge = _mm_load_si128(reinterpret_cast<const __m128i *>(EdgeMask));
+                    if (hideEdgeBackground) {
+                        bg = _mm_and_si128(bg, edge);
+                    }
+                    if (hideEdgeSprites) {
+                        spr = _mm_and_si128(spr, edge);
+                    }
+                }
+                __m128i bgTransparent = _mm_cmpeq_epi8(bg, zero);
+                __m128i sprOpaque = _mm_xor_si128(_mm_cmpeq_epi8(spr, zero), _mm_set1_epi8(-1));
+                __m128i sprFront = _mm_cmpeq_epi8(_mm_and_si128(spr, behindFlag), zero);
+                __m128i useSprite = _mm_and_si128(sprOpaque, _mm_or_si128(bgTransparent, sprFront));
+                __m128i result = _mm_or_si128(_mm_and_si128(useSprite, _mm_and_si128(spr, addrMask)),
+                                              _mm_andnot_si128(useSprite, bg));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(paletteAddrs + x), result);
+                hits = _mm_or_si128(hits, _mm_andnot_si128(bgTransparent, _mm_and_si128(spr, zeroFlag)));
+            }
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(hits, zero)) != 0xffff;
+        }
+
+        __attribute__((target("avx2")))
+        bool CompositeAVX2(const Byte *background, const Byte *sprites,
+                           bool hideEdgeBackground, bool hideEdgeSprites, Byte *paletteAddrs) {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i behindFlag = _mm256_set1_epi8(ScanlineCompositor::BehindBackground);
+            const __m256i zeroFlag = _mm256_set1_epi8(ScanlineCompositor::SpriteZero);
+            const __m256i addrMask = _mm256_set1_epi8(0x1f);
+            __m256i hits = zero;
+            for (unsigned x = 0; x < ScanlineCompositor::Width; x += 32) {
+                __m256i bg = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(background + x));
+                __m256i spr = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(sprites + x));
+                if (x == 0) {
+                    __m256i edge = _mm256_load_si256(reinterpret_cast<const __m256i *>(EdgeMask));
+                    if (hideEdgeBackground) {
+                        bg = _mm256_and_si256(bg, edge);
+                    }
+                    if (hideEdgeSprites) {
+                        spr = _mm256_and_si256(spr, edge);
+                    }
+                }
+                __m256i bgOpaque = _mm256_xor_si256(_mm256_cmpeq_epi8(bg, zero), _mm256_set1_epi8(-1));
+                __m256i sprTransparent = _mm256_cmpeq_epi8(spr, zero);
+                __m256i sprBehind = _mm256_xor_si256(_mm256_cmpeq_epi8(_mm256_and_si256(spr, behindFlag), zero),
+                                                     _mm256_set1_epi8(-1));
+                //The background stays where there is no sprite or the sprite is behind an opaque background
+                __m256i keepBackground = _mm256_or_si256(sprTransparent, _mm256_and_si256(bgOpaque, sprBehind));
+                __m256i result = _mm256_blendv_epi8(_mm256_and_si256(spr, addrMask), bg, keepBackground);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(paletteAddrs + x), result);
+                hits = _mm256_or_si256(hits, _mm256_and_si256(bgOpaque, _mm256_and_si256(spr, zeroFlag)));
+            }
+            return !_mm256_testz_si256(hits, hits);
+        }
+    }
+#endif
+
+    ScanlineCompositor::Kernel ScanlineCompositor::Select() {
+        return Supported().back();
+    }
+
+    std::vector<ScanlineCompositor::Kernel> ScanlineCompositor::Supported() {
+        std::vector<Kernel> kernels = {CompositeScalar};
+#ifdef ANNESE_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2")) {
+            kernels.push_back(CompositeSSE2);
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            kernels.push_back(CompositeAVX2);
+        }
+#endif
+        return kernels;
+    }
+}
@@ -1,40 +1,66 @@
 #include <cassert>
+#include <algorithm>
 #include <SFML/Graphics/RenderTarget.hpp>
 #include "../include/Screen.h"
+#include "../include/PaletteColors.h"
 
 namespace ANNESE {
+    static_assert(sizeof(sf::Color) == 4, "The texture is updated straight from the colors");
+
     Screen::Screen(sf::Vector2i screenSize, float pixelScale, sf::Color filling)
-            : mScreenSize(screenSize), mPixelScale(pixelScale) {
+            : mScreenSize(screenSize), mPixelScale(pixelScale),
+              mPictures(std::vector<sf::Color>(static_cast<std::size_t>(screenSize.x * screenSize.y), filling)) {
         assert(mScreenSize.x > 0 && mScreenSize.y > 0);
-        mVertices.resize(static_cast<size_t>(screenSize.x * screenSize.y * 6));  // 2 triangles
-        mVertices.setPrimitiveType(sf::Triangles);
-        for (int x = 0; x < mScreenSize.x; ++x) {
-            for (int y = 0; y < mScreenSize.y; ++y) {
-                size_t index = static_cast<size_t>((x * mScreenSize.y + y) * 6);
-                sf::Vector2f coords(x * mPixelScale, y * mPixelScale);
-
-                for (size_t i = 0; i < 6; ++i) {
-                    mVertices[index + i].position = coords +
-                                                    sf::Vector2f{mPixelScale * (i >= 1 && i <= 3 ? 1 : 0),
-                                                                 mPixelScale * (i >= 2 && i <= 4 ? 1 : 0)};
-                    mVertices[index + i].color = filling;
+        //An emphasized channel keeps its intensity while the others are dimmed (red, green and blue in this order)
+        for (int pixel = 0; pixel < FrameBuffer::ColorCount; ++pixel) {
+            sf::Color color(PaletteColors[pixel & FrameBuffer::ColorMask]);
+            int emphasis = pixel >> FrameBuffer::EmphasisShift;
+            if (emphasis) {
+                sf::Uint8 *channels[] = {&color.r, &color.g, &color.b};
+                for (int channel = 0; channel < 3; ++channel) {
+                    if (!(emphasis & (1 << channel))) {
+                        *channels[channel] = static_cast<sf::Uint8>(*channels[channel] * 3 / 4);
+                    }
                 }
             }
+            mColors[pixel] = color;
         }
+        mTexture.create(static_cast<unsigned>(mScreenSize.x), static_cast<unsigned>(mScreenSize.y));
+        mSprite.setTexture(mTexture);
+        mSprite.setScale(mPixelScale, mPixelScale);
     }
 
-    void Screen::setPixel(Pixel pixel, sf::Color color) {
-        size_t index = static_cast<size_t>((pixel.x * mScreenSize.y + pixel.y) * 6);
-        if (index >= mVertices.getVertexCount()) {
-            return;
+    void Screen::setPicture(const FrameBuffer &picture) {
+        std::vector<sf::Color> &colors = mPictures.back();
+        int width = std::min(mScreenSize.x, FrameBuffer::Width);
+        int height = std::min(mScreenSize.y, FrameBuffer::Height);
+        for (int y = 0; y < height; ++y) {
+            const FrameBuffer::Pixel *row = picture.row(y);
+            sf::Color *pixels = &colors[y * mScreenSize.x];
+            for (int x = 0; x < width; ++x) {
+                pixels[x] = mColors[row[x] % FrameBuffer::ColorCount];
+            }
         }
+        mPictures.publish();
+    }
 
-        for (size_t i = 0; i < 6; ++i) {
-            mVertices[index + i].color = color;
+    const std::vector<sf::Color> &Screen::pixels() {
+        updatePicture();
+        return mPictures.front();
+    }
+
+    void Screen::updatePicture() const {
+        if (mPictures.update()) {
+            mTextureOutdated = true;
         }
     }
 
     void Screen::draw(sf::RenderTarget &target, sf::RenderStates states) const {
-        target.draw(mVertices, states);
+        updatePicture();
+        if (mTextureOutdated) {
+            mTexture.update(reinterpret_cast<const sf::Uint8 *>(mPictures.front().data()));
+            mTextureOutdated = false;
+        }
+        target.draw(mSprite, states);
     }
 }
\ No newline at end of file
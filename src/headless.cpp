@@ -0,0 +1,75 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include "../include/Console.h"
+#include "../include/HeadlessBackend.h"
+#include "../include/Mapper.h"
+
+static void printHelp(char *name) {
+    std::cout << "Usage: \n> " << name << " <path_to_cartridge> <frames> [<picture_output>]\n"
+              << "Runs as fast as possible without a display and prints a hash of the last picture.\n"
+              << "The picture is written as 256x240 16 bit pixels, the color index and the emphasis bits\n"
+              << "To compare the mappers, build with -DCMAKE_BUILD_TYPE=Release and run a cartridge of each type,\n"
+              << "benchmark/MapperBenchmark.sh does it with the bundled ones\n";
+}
+
+static const char *MapperName(ANNESE::Mapper::Type type) {
+    switch (type) {
+        case ANNESE::Mapper::Type::NROM:
+            return "NROM";
+        case ANNESE::Mapper::Type::SxROM:
+            return "SxROM";
+        case ANNESE::Mapper::Type::UxROM:
+            return "UxROM";
+        case ANNESE::Mapper::Type::CNROM:
+            return "CNROM";
+    }
+    return "unknown";
+}
+
+/// FNV-1a over the pixels
+static std::uint64_t HashPicture(const ANNESE::FrameBuffer &picture) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (int i = 0; i < ANNESE::FrameBuffer::Width * ANNESE::FrameBuffer::Height; ++i) {
+        hash ^= picture.data()[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 3 && argc != 4) {
+        printHelp(argv[0]);
+        return 0;
+    }
+    std::uint64_t frames = std::strtoull(argv[2], nullptr, 10);
+
+    std::ifstream rom(argv[1], std::ios::binary);
+    auto video = std::make_shared<ANNESE::HeadlessVideo>();
+    ANNESE::Console console(video, std::make_shared<ANNESE::HeadlessInput>(),
+                            std::make_shared<ANNESE::HeadlessInput>());
+    if (!console.load(rom)) {
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    while (video->pictureCount() < frames) {
+        console.runFrame();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "Mapper: " << MapperName(console.mapper()->type()) << ", frames: " << video->pictureCount()
+              << ", picture hash: " << std::hex << HashPicture(video->picture()) << std::dec << ", "
+              << elapsed.count() << " s, " << video->pictureCount() / elapsed.count() << " frames/s, "
+              << elapsed.count() * 1000 / video->pictureCount() << " ms/frame" << std::endl;
+
+    if (argc == 4) {
+        std::ofstream pictureOut(argv[3], std::ios::binary);
+        pictureOut.write(reinterpret_cast<const char *>(video->picture().data()),
+                         sizeof(ANNESE::FrameBuffer::Pixel) * ANNESE::FrameBuffer::Width *
+                         ANNESE::FrameBuffer::Height);
+    }
+    return 0;
+}
@@ -3,6 +3,7 @@
 #include <iostream>
 #include "../include/ConfigManager.h"
 #include "../include/Emulator.h"
+#include "../include/Profiler.h"
 #include "../include/TeeLog.hpp"
 
 static constexpr const char *Zelda = "cartridges/Legend of Zelda, The (U) (PRG1) [!].nes";
@@ -14,11 +15,14 @@ static constexpr const char *Fight = "cartridges/10-Yard Fight (Japan).nes";
 static constexpr const char *Contra = "cartridges/Contra (USA).nes";
 
 static void printHelp(char *name) {
-    std::cout << "Usage: \n> " << name << " <path_to_cartridge>";
+    std::cout << "Usage: \n> " << name << " <path_to_cartridge> [<profile_output>]\n"
+              << "The profile is written in the folded stacks format, the summary is printed on exit";
 }
 
+static constexpr const std::size_t ProfileSummaryLength = 30;
+
 int main(int argc, char *argv[]) {
-    if (argc != 2) {
+    if (argc != 2 && argc != 3) {
         printHelp(argv[0]);
         return 0;
     }
@@ -35,8 +39,19 @@ int main(int argc, char *argv[]) {
     std::ifstream rom(Contra);
 //    std::ifstream rom(argv[1]);
     ANNESE::Emulator emulator(configManager.configuration);
+    std::shared_ptr<ANNESE::Profiler> profiler;
+    if (argc == 3) {
+        profiler = std::make_shared<ANNESE::Profiler>();
+        emulator.setProfiler(profiler);
+    }
     emulator.run(rom);
 
+    if (profiler) {
+        std::ofstream profileOut(argv[2]);
+        profiler->writeFoldedStacks(profileOut);
+        profiler->writeSummary(std::cout, ProfileSummaryLength);
+    }
+
     std::ofstream confOut("config.toml");
     configManager.store(confOut);
     return 0;
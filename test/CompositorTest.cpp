@@ -0,0 +1,42 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include "../include/ScanlineCompositor.h"
+
+using namespace ANNESE;
+
+/// Every kernel the CPU supports must give the same palette addresses and the same sprite 0 hit as the scalar
+/// one on random lines
+int main() {
+    std::vector<ScanlineCompositor::Kernel> kernels = ScanlineCompositor::Supported();
+    std::mt19937 random(2024);
+    Byte background[ScanlineCompositor::Width], sprites[ScanlineCompositor::Width];
+    Byte expected[ScanlineCompositor::Width], actual[ScanlineCompositor::Width];
+    int lines = 200000, hits = 0, failures = 0;
+    for (int line = 0; line < lines; ++line) {
+        //Lines from almost all transparent to almost all opaque, so that both ways of the sprite 0 test show up
+        unsigned bgDensity = random() % 9, sprDensity = random() % 9;
+        for (unsigned x = 0; x < ScanlineCompositor::Width; ++x) {
+            background[x] = random() % 8 < bgDensity ? static_cast<Byte>(random() % 0x10) : 0;
+            sprites[x] = random() % 8 < sprDensity
+                         ? static_cast<Byte>(0x10 | random() % 0x10 |
+                                             (random() & (ScanlineCompositor::BehindBackground |
+                                                          ScanlineCompositor::SpriteZero)))
+                         : 0;
+        }
+        bool hideEdgeBackground = random() & 1, hideEdgeSprites = random() & 1;
+        bool expectedHit = ScanlineCompositor::CompositeScalar(background, sprites, hideEdgeBackground,
+                                                               hideEdgeSprites, expected);
+        hits += expectedHit;
+        for (std::size_t i = 1; i < kernels.size(); ++i) {
+            bool hit = kernels[i](background, sprites, hideEdgeBackground, hideEdgeSprites, actual);
+            if ((hit != expectedHit || !std::equal(expected, expected + ScanlineCompositor::Width, actual)) &&
+                ++failures <= 10) {
+                std::cout << "Kernel " << i << " differs on line " << line << std::endl;
+            }
+        }
+    }
+    std::cout << lines << " lines composited by " << kernels.size() << " kernels, " << hits
+              << " with a sprite 0 hit, " << failures << " different" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+#include <iostream>
+#include "TracingConsole.h"
+
+using namespace ANNESE;
+
+/// The block cache and the compiled blocks are only faster ways to run the same instructions: every bundled game
+/// must see the PPU at the same cycles and show the same pictures as with the interpreter
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        std::cout << "Usage: \n> " << argv[0] << " <cartridge_directory>" << std::endl;
+        return 2;
+    }
+    bool same = true;
+    for (CPU::ExecutionMode mode : {CPU::ExecutionMode::Interpreter, CPU::ExecutionMode::BlockCache}) {
+        std::cout << (mode == CPU::ExecutionMode::Interpreter ? "Interpreter" : "Block cache")
+                  << " against compiled blocks" << std::endl;
+        same &= TracingConsole::Compare(argv[1], 600, [mode](TracingConsole &console) {
+            console.setExecutionMode(mode);
+        });
+    }
+    return same ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../include/Console.h"
+#include "../include/MainBus.h"
+#include "../include/PPU.h"
+#include "../include/HeadlessBackend.h"
+
+using namespace ANNESE;
+
+/// A console that keeps the CPU cycle of every PPUSTATUS read
+class TimingConsole : public Console {
+public:
+    TimingConsole()
+            : Console(std::make_shared<HeadlessVideo>(), std::make_shared<HeadlessInput>(),
+                      std::make_shared<HeadlessInput>()) {
+        mMainBus->setReadCallback<TimingConsole, &TimingConsole::readStatus>(IORegisters::PPUStatus, this);
+    }
+
+    const std::vector<CycleCount> &reads() const {
+        return mReads;
+    }
+
+protected:
+    Byte readStatus() {
+        mReads.push_back(cycles());
+        return mPPU->status();
+    }
+
+    std::vector<CycleCount> mReads;
+};
+
+/// The sprite DMA takes 513 cycles after the instruction that writes OAMDMA, and one more when that write,
+/// the last cycle of the instruction, is an odd one
+int main() {
+    //NROM with one PRG bank, the loop runs at $8000. Every DMA ends on the same parity, so the two writes are
+    //an odd and an even number of cycles after the end of the previous DMA, one of them on an odd cycle
+    const std::vector<Byte> loop = {
+            0xad, 0x02, 0x20, //LDA $2002
+            0x8d, 0x14, 0x40, //STA $4014
+            0xad, 0x02, 0x20, //LDA $2002
+            0xea,             //NOP
+            0xad, 0x02, 0x20, //LDA $2002
+            0x8d, 0x14, 0x40, //STA $4014
+            0xad, 0x02, 0x20, //LDA $2002
+            0x4c, 0x00, 0x80, //JMP $8000
+    };
+    std::string image = std::string("NES\x1a", 4) + '\x01' + '\x01' + std::string(10, '\0');
+    std::string prg(loop.begin(), loop.end());
+    prg.resize(0x4000);
+    //Reset vector
+    prg[0x3ffc] = '\x00';
+    prg[0x3ffd] = '\x80';
+    image += prg + std::string(0x2000, '\0');
+
+    TimingConsole console;
+    std::istringstream rom(image);
+    if (!console.load(rom)) {
+        return 1;
+    }
+    console.runFrame();
+    console.runFrame();
+
+    const std::vector<CycleCount> &reads = console.reads();
+    int even = 0, odd = 0, failures = 0;
+    for (std::size_t i = 0; i + 1 < reads.size(); i += 2) {
+        //The STA starts right after the first read and takes 4 cycles
+        CycleCount write = reads[i] + 4 + 3;
+        CycleLength length = static_cast<CycleLength>(reads[i + 1] - reads[i] - 8);
+        CycleLength expected = 513 + (write & 1);
+        (write & 1 ? odd : even) += 1;
+        if (length != expected && ++failures <= 10) {
+            std::cout << "Write on cycle " << write << ": the DMA took " << length << " cycles instead of "
+                      << expected << std::endl;
+        }
+    }
+    std::cout << even << " writes on even cycles, " << odd << " on odd ones, " << failures << " wrong" << std::endl;
+    return failures == 0 && even > 0 && odd > 0 ? 0 : 1;
+}
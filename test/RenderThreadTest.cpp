@@ -0,0 +1,17 @@
+#include <iostream>
+#include "TracingConsole.h"
+
+using namespace ANNESE;
+
+/// The renderer thread must change neither the pictures nor when the game sees the sprite 0 hit:
+/// the emulation thread finds the hit on its own while the worker renders the line
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        std::cout << "Usage: \n> " << argv[0] << " <cartridge_directory>" << std::endl;
+        return 2;
+    }
+    bool same = TracingConsole::Compare(argv[1], 600, [](TracingConsole &console) {
+        console.setRenderThread(true);
+    });
+    return same ? 0 : 1;
+}
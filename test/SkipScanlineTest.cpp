@@ -0,0 +1,136 @@
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+#include "../include/Cartridge.h"
+#include "../include/Mapper.h"
+#include "../include/PictureBus.h"
+#include "../include/PPU.h"
+#include "../include/HeadlessBackend.h"
+
+using namespace ANNESE;
+
+/// Steps a PPU through frames of random pictures and, on every scanline, compares the sprite 0 hit and the VRAM
+/// address a skipped line leaves with what ScanlineRenderer::Render finds for the same line
+class CheckingPPU : public PPU {
+public:
+    CheckingPPU(std::shared_ptr<PictureBus> pictureBus, std::mt19937 &random)
+            : PPU(std::move(pictureBus), std::make_shared<HeadlessVideo>()), mRandom(random) {
+    }
+
+    /// Randomizes the memory and the registers, then runs until the vertical blank
+    void runFrame() {
+        reset();
+        for (Address addr = 0; addr < 0x3000; ++addr) {
+            //About half of the pixels of the pattern tables are transparent
+            mPictureBus->write(addr, addr < 0x2000 ? byte() & byte() : byte());
+        }
+        mPictureBus->setMirroring(mRandom() & 1 ? CHRMemory::NameTableMirroring::Vertical
+                                                : CHRMemory::NameTableMirroring::Horizontal);
+        for (Byte &value : mSpriteMemory) {
+            value = byte();
+        }
+        OAMAddress(0);
+        control(byte() & Byte(0x3f));
+        mask(byte() | Byte(0x18));
+        scroll(byte());
+        scroll(byte());
+
+        std::uint64_t frame = frameCount();
+        while (frameCount() == frame) {
+            if (mPipelineState == State::Render && mCycle == ScanlineVisibleDots && mRenderedDots == 0) {
+                check();
+            } else if (mPipelineState == State::Render && mCycle == ScanlineVisibleDots + 2) {
+                changeLine();
+            }
+            step();
+        }
+    }
+
+    int checkedLines() const {
+        return mCheckedLines;
+    }
+
+    int hitLines() const {
+        return mHitLines;
+    }
+
+    int failures() const {
+        return mFailures;
+    }
+
+protected:
+    Byte byte() {
+        return static_cast<Byte>(mRandom());
+    }
+
+    /// Once the scanline is done, puts the sprite 0 somewhere on the next one and sometimes changes the registers,
+    /// as games do between lines
+    void changeLine() {
+        int length = mLongSprites ? 16 : 8;
+        mSpriteMemory[0] = static_cast<Byte>(mScanline - static_cast<int>(mRandom() % length));
+        mSpriteMemory[1] = byte();
+        mSpriteMemory[2] = byte();
+        mSpriteMemory[3] = byte();
+        if (mRandom() % 8 == 0) {
+            control(byte() & Byte(0x3f));
+            mask(byte() | Byte(0x18));
+            scroll(byte());
+            scroll(byte());
+            mDataAddress = mTempAddress;
+        }
+    }
+
+    void check() {
+        //Every line may hit, not just the first one of the frame
+        mSprZeroHit = false;
+        Address dataAddress = mDataAddress;
+        skipScanline();
+        bool skippedHit = mSprZeroHit;
+        Address skippedAddress = mDataAddress;
+        mSprZeroHit = false;
+        mDataAddress = dataAddress;
+
+        FrameBuffer::Pixel row[ScanlineVisibleDots];
+        bool renderedHit = ScanlineRenderer::Render(scanlineState(), *mPictureBus, mCompositeScanline, row);
+        Address renderedAddress = mShowBackground ? dataAddress ^ Address(0x0400) : dataAddress;
+
+        ++mCheckedLines;
+        mHitLines += renderedHit;
+        if (skippedHit != renderedHit || skippedAddress != renderedAddress) {
+            if (++mFailures <= 10) {
+                std::cout << "Scanline " << mScanline << std::hex << ", VRAM address " << dataAddress
+                          << ", fine X " << +mFineXScroll << ", mirroring "
+                          << +static_cast<Byte>(mPictureBus->nameTableMirroring()) << ", sprite 0 at "
+                          << +mSpriteMemory[3] << "," << +mSpriteMemory[0] << ": skipped hit " << skippedHit
+                          << " address " << skippedAddress << ", rendered hit " << renderedHit << " address "
+                          << renderedAddress << std::dec << std::endl;
+            }
+        }
+    }
+
+    std::mt19937 &mRandom;
+
+    int mCheckedLines = 0;
+
+    int mHitLines = 0;
+
+    int mFailures = 0;
+};
+
+int main() {
+    //A cartridge with CHR RAM, so that the pattern tables can be written
+    auto cartridge = std::make_unique<Cartridge>(std::vector<Byte>(0x4000), std::vector<Byte>(), 0, 0, false);
+    std::shared_ptr<Mapper> mapper = Mapper::Create(std::move(cartridge), []() {});
+    auto pictureBus = std::make_shared<PictureBus>();
+    pictureBus->setCHRMemory(mapper);
+
+    std::mt19937 random(2024);
+    CheckingPPU ppu(pictureBus, random);
+    for (int frame = 0; frame < 50; ++frame) {
+        ppu.runFrame();
+    }
+    std::cout << ppu.checkedLines() << " scanlines checked, " << ppu.hitLines() << " with a sprite 0 hit, "
+              << ppu.failures() << " different" << std::endl;
+    return ppu.failures() == 0 && ppu.hitLines() > 0 ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+#include <iostream>
+#include <memory>
+#include <random>
+#include "../include/PictureBus.h"
+#include "../include/PPU.h"
+#include "../include/HeadlessBackend.h"
+
+using namespace ANNESE;
+
+/// Fills the OAM with random sprites and compares the sprites found on every visible scanline with the one sprite
+/// at a time search
+class RangePPU : public PPU {
+public:
+    explicit RangePPU(std::mt19937 &random)
+            : PPU(std::make_shared<PictureBus>(), std::make_shared<HeadlessVideo>()), mRandom(random) {
+    }
+
+    /// The number of scanlines where the two disagree
+    int check() {
+        for (std::size_t i = 0; i < mSpriteMemory.size(); ++i) {
+            //Half of the Y coordinates near the ends of the range, where the unsigned comparisons may go wrong
+            mSpriteMemory[i] = static_cast<Byte>(i % 4 == 0 && mRandom() % 2 ? mRandom() % 24 - 8 : mRandom());
+        }
+        mLongSprites = mRandom() % 2;
+
+        int failures = 0;
+        for (int scanline = 0; scanline < static_cast<int>(VisibleScanlines); ++scanline) {
+            if (spritesInRange(scanline) != spritesInRangeScalar(scanline)) {
+                if (++failures <= 10) {
+                    std::cout << "Scanline " << scanline << (mLongSprites ? ", 8x16" : ", 8x8") << " sprites: "
+                              << std::hex << spritesInRange(scanline) << " instead of "
+                              << spritesInRangeScalar(scanline) << std::dec << std::endl;
+                }
+            }
+        }
+        return failures;
+    }
+
+protected:
+    std::mt19937 &mRandom;
+};
+
+int main() {
+    std::mt19937 random(2024);
+    RangePPU ppu(random);
+    int tables = 10000, failures = 0;
+    for (int i = 0; i < tables; ++i) {
+        failures += ppu.check();
+    }
+    std::cout << tables << " OAM tables checked, " << failures << " scanlines different" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
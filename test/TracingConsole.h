@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "../include/Console.h"
+#include "../include/CPU.h"
+#include "../include/MainBus.h"
+#include "../include/PPU.h"
+#include "../include/HeadlessBackend.h"
+
+namespace ANNESE {
+    /// A console that records what the game sees of the PPU: every PPUSTATUS read that returns another value than
+    /// the previous one, with its CPU cycle, so that a sprite 0 hit or a vertical blank found at another time shows
+    /// up. The reads in between are left out since the block cache skips those of an idle polling loop.
+    /// The pictures are recorded too
+    class TracingConsole : public Console {
+    public:
+        explicit TracingConsole(std::shared_ptr<HeadlessInput> input)
+                : Console(std::make_shared<HeadlessVideo>(), std::move(input), std::make_shared<HeadlessInput>()) {
+            mMainBus->setReadCallback<TracingConsole, &TracingConsole::readStatus>(IORegisters::PPUStatus, this);
+        }
+
+        void setExecutionMode(CPU::ExecutionMode mode) {
+            mCPU->setExecutionMode(mode);
+        }
+
+        /// FNV-1a over the PPUSTATUS changes since the last call
+        std::uint64_t takeTrace() {
+            std::uint64_t trace = mTrace;
+            mTrace = HashStart;
+            return trace;
+        }
+
+        /// FNV-1a over the pixels of the last picture
+        std::uint64_t pictureHash() const {
+            std::uint64_t hash = HashStart;
+            for (int i = 0; i < FrameBuffer::Width * FrameBuffer::Height; ++i) {
+                hash = Hash(hash, mPPU->frame().data()[i]);
+            }
+            return hash;
+        }
+
+        /// The trace and the picture of every frame, with the buttons pressed by a fixed script once the game
+        /// is past its title screen. Configures the console before the cartridge is loaded
+        static std::vector<std::uint64_t> Run(const std::filesystem::path &cartridge, int frames,
+                                              const std::function<void(TracingConsole &)> &configure) {
+            auto input = std::make_shared<HeadlessInput>();
+            TracingConsole console(input);
+            configure(console);
+            std::ifstream rom(cartridge, std::ios::binary);
+            std::vector<std::uint64_t> record;
+            if (!console.load(rom)) {
+                return record;
+            }
+            std::uint32_t script = 1;
+            for (int frame = 0; frame < frames; ++frame) {
+                if (frame % 8 == 0) {
+                    script = script * 1103515245 + 12345;
+                    //Anything but Select, and Start now and then
+                    Byte buttons = static_cast<Byte>(script >> 16) & Byte(0xfb);
+                    if (frame % 240 < 16) {
+                        buttons |= 0x08;
+                    }
+                    input->setButtons(frame < 120 ? 0 : buttons);
+                }
+                console.runFrame();
+                record.push_back(console.takeTrace());
+                record.push_back(console.pictureHash());
+            }
+            return record;
+        }
+
+        /// Runs every bundled cartridge as it is and configured, tells the first frame where they part
+        static bool Compare(const std::filesystem::path &cartridgeDir, int frames,
+                            const std::function<void(TracingConsole &)> &configure) {
+            bool same = true;
+            for (const auto &entry : std::filesystem::directory_iterator(cartridgeDir)) {
+                if (entry.path().extension() != ".nes") {
+                    continue;
+                }
+                std::vector<std::uint64_t> expected = Run(entry.path(), frames, [](TracingConsole &) {});
+                std::vector<std::uint64_t> actual = Run(entry.path(), frames, configure);
+                std::size_t i = 0;
+                while (i < expected.size() && i < actual.size() && expected[i] == actual[i]) {
+                    ++i;
+                }
+                std::cout << entry.path().filename().string() << ": ";
+                if (expected.empty() || i != expected.size() || i != actual.size()) {
+                    std::cout << (i % 2 ? "the picture" : "PPUSTATUS") << " differs on frame " << i / 2 << std::endl;
+                    same = false;
+                } else {
+                    std::cout << "same for " << frames << " frames" << std::endl;
+                }
+            }
+            return same;
+        }
+
+    protected:
+        static constexpr const std::uint64_t HashStart = 14695981039346656037ull;
+
+        static std::uint64_t Hash(std::uint64_t hash, std::uint64_t value) {
+            return (hash ^ value) * 1099511628211ull;
+        }
+
+        Byte readStatus() {
+            Byte status = mPPU->status();
+            if (status != mLastStatus) {
+                mTrace = Hash(Hash(mTrace, static_cast<std::uint64_t>(cycles())), status);
+                mLastStatus = status;
+            }
+            return status;
+        }
+
+        std::uint64_t mTrace = HashStart;
+
+        int mLastStatus = -1;
+    };
+}